@@ -2,25 +2,168 @@
 #include <cctk_Schedule.h>
 #include <iostream>
 #include <cctk_Parameters.h>
+#include <cctk_Functions.h>
 #include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "fcall_event.h"
 
 namespace fcall {
 
+  // The memory-mapped event trace of this process
+  struct event_trace {
+    int fd = -1;
+    FILE *names = 0;
+    size_t capacity = 0;
+    fcall_trace_header *header = 0;
+    fcall_event *events = 0;
+    std::string base;
+    bool has_rl = false, has_map = false;
+    // schedule item -> (routine id, bin id)
+    std::unordered_map<const cFunctionData *,std::pair<int,int> > ids;
+    std::map<std::string,int> routine_names, bins;
+  };
+  event_trace trace;
+
+  bool open_trace() {
+    DECLARE_CCTK_PARAMETERS;
+    char name[1024];
+    const int rank = CCTK_MyProc(NULL);
+    snprintf(name,sizeof(name),"%s.%d",trace_file,rank);
+    trace.base = name;
+    trace.fd = open((trace.base+".bin").c_str(),O_RDWR|O_CREAT|O_TRUNC,0644);
+    if(trace.fd < 0) {
+      CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot create %s.bin",name);
+      return false;
+    }
+    trace.capacity = trace_capacity;
+    const size_t size = sizeof(fcall_trace_header) + trace.capacity*sizeof(fcall_event);
+    void *p = MAP_FAILED;
+    if(ftruncate(trace.fd,size) == 0)
+      p = mmap(0,size,PROT_READ|PROT_WRITE,MAP_SHARED,trace.fd,0);
+    if(p == MAP_FAILED) {
+      CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot map %s.bin",name);
+      close(trace.fd);
+      trace.fd = -1;
+      return false;
+    }
+    trace.names = fopen((trace.base+".names").c_str(),"w");
+    if(trace.names == 0) {
+      CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot create %s.names",name);
+      munmap(p,size);
+      close(trace.fd);
+      trace.fd = -1;
+      return false;
+    }
+    trace.header = (fcall_trace_header *)p;
+    trace.events = (fcall_event *)(trace.header+1);
+    memcpy(trace.header->magic,FCALL_TRACE_MAGIC,8);
+    trace.header->rank = rank;
+    trace.header->event_size = sizeof(fcall_event);
+    trace.has_rl = CCTK_IsFunctionAliased("GetRefinementLevel");
+    trace.has_map = CCTK_IsFunctionAliased("GetMap");
+    return true;
+  }
+
+  // Names are written as soon as they get an id, so that the trace
+  // of a run that crashes can be read as well
+  int intern(std::map<std::string,int>& ids,const char *kind,const std::string& name) {
+    auto i = ids.find(name);
+    if(i != ids.end())
+      return i->second;
+    int id = ids.size();
+    ids[name] = id;
+    fprintf(trace.names,"%s %d %s\n",kind,id,name.c_str());
+    fflush(trace.names);
+    return id;
+  }
+
+  void record(const cGH *cctkGH,const cFunctionData *attribute,int kind) {
+    if(trace.header == 0)
+      return;
+    fcall_trace_header& h = *trace.header;
+    if(size_t(h.nevents) == trace.capacity) {
+      h.ndropped++;
+      return;
+    }
+    auto r = trace.ids.find(attribute);
+    if(r == trace.ids.end()) {
+      std::string name = attribute->thorn;
+      name += "::";
+      name += attribute->routine;
+      std::pair<int,int> id(intern(trace.routine_names,"routine",name),
+                            intern(trace.bins,"bin",attribute->where));
+      r = trace.ids.insert(std::make_pair(attribute,id)).first;
+    }
+    fcall_event& e = trace.events[h.nevents];
+    e.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+    e.routine = r->second.first;
+    e.bin = r->second.second;
+    e.iteration = cctkGH->cctk_iteration;
+    e.rl = trace.has_rl ? GetRefinementLevel(cctkGH) : 0;
+    e.map = trace.has_map ? GetMap(cctkGH) : -1;
+    e.kind = kind;
+    e.reserved = 0;
+    h.nevents++;
+  }
+
   int pre_call(const void *arg1,void *arg2,void *arg3,void *arg4) {
+    DECLARE_CCTK_PARAMETERS;
     const cGH *cctkGH = (const cGH *)arg1;
     const cFunctionData *attribute = (const cFunctionData *)arg3;
-    std::cout << "/=== " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where << "\n";
+    if(CCTK_Equals(output,"events"))
+      record(cctkGH,attribute,FCALL_BEGIN);
+    else if(CCTK_Equals(output,"text"))
+      std::cout << "/=== " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where << "\n";
     return 0;
   }
 
   int post_call(const void *arg1,void *arg2,void *arg3,void *arg4) {
+    DECLARE_CCTK_PARAMETERS;
     const cGH *cctkGH = (const cGH *)arg1;
     const cFunctionData *attribute = (const cFunctionData *)arg3;
-    std::cout << "\\=== " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where << "\n";
+    if(CCTK_Equals(output,"events"))
+      record(cctkGH,attribute,FCALL_END);
+    else if(CCTK_Equals(output,"text"))
+      std::cout << "\\=== " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where << "\n";
     return 0;
   }
 
   extern "C" void FCall_AddDiagnosticCalls() {
+    DECLARE_CCTK_PARAMETERS;
+    if(CCTK_Equals(output,"none"))
+      return;
+    if(CCTK_Equals(output,"events"))
+      open_trace();
     RegisterScheduleWrapper(pre_call,post_call);
   }
+
+  // Unmap the trace and cut it to the recorded events
+  extern "C" void FCall_CloseTrace() {
+    if(trace.header == 0)
+      return;
+    const int64_t nevents = trace.header->nevents;
+    if(trace.header->ndropped > 0)
+      CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,
+        "%lld events were dropped, increase trace_capacity",(long long)trace.header->ndropped);
+    munmap(trace.header,sizeof(fcall_trace_header) + trace.capacity*sizeof(fcall_event));
+    trace.header = 0;
+    trace.events = 0;
+    if(ftruncate(trace.fd,sizeof(fcall_trace_header) + nevents*sizeof(fcall_event)) != 0)
+      CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot truncate %s.bin",trace.base.c_str());
+    close(trace.fd);
+    trace.fd = -1;
+    fclose(trace.names);
+    trace.names = 0;
+  }
 }
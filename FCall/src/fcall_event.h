@@ -0,0 +1,37 @@
+#ifndef FCALL_EVENT_H
+#define FCALL_EVENT_H
+
+/* Binary event trace written by FCall with output = "events".
+
+   Each process writes <trace_file>.<rank>.bin: an fcall_trace_header
+   followed by header.nevents fixed-size fcall_event records, and
+   <trace_file>.<rank>.names: lines "routine <id> <thorn::routine>" and
+   "bin <id> <schedule bin>" naming the ids used in the events.
+   FCall/util/fcall2json.cc converts the traces to Chrome trace JSON. */
+
+#include <stdint.h>
+
+#define FCALL_TRACE_MAGIC "FCALLTR1"
+
+typedef struct {
+  char magic[8];      /* FCALL_TRACE_MAGIC */
+  int32_t rank;
+  int32_t event_size; /* sizeof(fcall_event) */
+  int64_t nevents;    /* records written, kept up to date while running */
+  int64_t ndropped;   /* records not written because the file was full */
+} fcall_trace_header;
+
+enum { FCALL_BEGIN = 0, FCALL_END = 1 };
+
+typedef struct {
+  int64_t time_ns;    /* wall clock, ns since the epoch */
+  int32_t routine;    /* routine id */
+  int32_t bin;        /* schedule bin id */
+  int32_t iteration;
+  int16_t rl;         /* refinement level */
+  int16_t map;        /* -1 outside of local mode */
+  int32_t kind;       /* FCALL_BEGIN or FCALL_END */
+  int32_t reserved;
+} fcall_event;
+
+#endif
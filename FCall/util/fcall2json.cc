@@ -0,0 +1,131 @@
+// Convert the binary event traces written by FCall (output = "events")
+// to Chrome trace JSON, for chrome://tracing or https://ui.perfetto.dev
+//
+//   c++ -O2 -o fcall2json fcall2json.cc
+//   ./fcall2json fcall_trace.*.bin > trace.json
+//
+// Every process becomes a "pid", and the calls nest as they did in the
+// run. Times are relative to the earliest event of all traces.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/fcall_event.h"
+
+namespace {
+
+  struct trace_t {
+    fcall_trace_header header;
+    std::vector<fcall_event> events;
+    std::map<int,std::string> routines, bins;
+  };
+
+  bool read_trace(const std::string& file,trace_t& t) {
+    std::ifstream in(file,std::ios::binary);
+    if(!in.read((char *)&t.header,sizeof(t.header))) {
+      std::cerr << file << ": cannot read the header" << std::endl;
+      return false;
+    }
+    if(memcmp(t.header.magic,FCALL_TRACE_MAGIC,8) != 0 || t.header.event_size != sizeof(fcall_event)) {
+      std::cerr << file << ": not an FCall event trace" << std::endl;
+      return false;
+    }
+    t.events.resize(t.header.nevents);
+    if(!in.read((char *)t.events.data(),t.events.size()*sizeof(fcall_event))) {
+      std::cerr << file << ": truncated" << std::endl;
+      return false;
+    }
+    if(t.header.ndropped > 0)
+      std::cerr << file << ": " << t.header.ndropped << " events were dropped in the run" << std::endl;
+
+    std::string names = file;
+    if(names.size() > 4 && names.compare(names.size()-4,4,".bin") == 0)
+      names.erase(names.size()-4);
+    names += ".names";
+    std::ifstream nin(names);
+    if(!nin) {
+      std::cerr << names << ": cannot open" << std::endl;
+      return false;
+    }
+    std::string line;
+    while(std::getline(nin,line)) {
+      std::istringstream ls(line);
+      std::string kind, name;
+      int id;
+      if(!(ls >> kind >> id))
+        continue;
+      std::getline(ls >> std::ws,name);
+      (kind == "routine" ? t.routines : t.bins)[id] = name;
+    }
+    return true;
+  }
+
+  std::string quote(const std::string& s) {
+    std::string q = "\"";
+    for(char c : s) {
+      if(c == '"' || c == '\\') {
+        q += '\\';
+        q += c;
+      } else if((unsigned char)c < 0x20) {
+        char buf[8];
+        snprintf(buf,sizeof(buf),"\\u%04x",c);
+        q += buf;
+      } else {
+        q += c;
+      }
+    }
+    return q + "\"";
+  }
+
+  std::string lookup(const std::map<int,std::string>& names,int id) {
+    auto i = names.find(id);
+    return i == names.end() ? "?" + std::to_string(id) : i->second;
+  }
+}
+
+int main(int argc,char **argv) {
+  if(argc < 2) {
+    std::cerr << "usage: " << argv[0] << " trace.<rank>.bin ..." << std::endl;
+    return 1;
+  }
+  std::vector<trace_t> traces(argc-1);
+  int64_t t0 = INT64_MAX;
+  for(int n=1;n<argc;n++) {
+    if(!read_trace(argv[n],traces[n-1]))
+      return 1;
+    if(!traces[n-1].events.empty())
+      t0 = std::min(t0,traces[n-1].events[0].time_ns);
+  }
+
+  std::cout << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  for(const trace_t& t : traces) {
+    const int pid = t.header.rank;
+    std::cout << (first ? "" : ",\n")
+      << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+      << ",\"args\":{\"name\":\"rank " << pid << "\"}}";
+    first = false;
+    for(const fcall_event& e : t.events) {
+      char ts[32];
+      snprintf(ts,sizeof(ts),"%.3f",(e.time_ns - t0)*1e-3);
+      std::cout << ",\n{\"name\":" << quote(lookup(t.routines,e.routine))
+        << ",\"cat\":" << quote(lookup(t.bins,e.bin))
+        << ",\"ph\":\"" << (e.kind == FCALL_BEGIN ? 'B' : 'E')
+        << "\",\"ts\":" << ts << ",\"pid\":" << pid << ",\"tid\":0";
+      if(e.kind == FCALL_BEGIN)
+        std::cout << ",\"args\":{\"iteration\":" << e.iteration
+          << ",\"rl\":" << e.rl << ",\"map\":" << e.map << "}";
+      std::cout << "}";
+    }
+  }
+  std::cout << "\n]}\n";
+  return 0;
+}
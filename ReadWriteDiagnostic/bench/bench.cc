@@ -0,0 +1,286 @@
+// Microbenchmarks of the ReadWriteDiagnostic kernels on a mock grid,
+// without a Cactus configuration. See README for how to build and run.
+//
+// Options, all comma separated lists:
+//   -n SIZES     grid points per direction (default 16,32,64,96)
+//   -g GHOSTS    ghost zone widths (default 1,3)
+//   -v COUNTS    number of variables checked (default 1,8,24)
+//   -e ENGINES   checksum engines (default xorfold,crc32c,mulmix)
+//   -w MODES     write_detection of the hooks kernel (default checksum,shadow)
+//   -k KERNELS   cksum,regions,shadow,internet,hooks,varptr,clauses
+//                (default all)
+//   -t THREADS   threads for the checksums, 0 for the OpenMP default
+//                (default 1)
+//   -s SECONDS   minimum time per measurement (default 0.2)
+//
+// Every measurement prints one line: the kernel, its settings, the time
+// per point (per call for varptr, per clause for clauses) and the
+// bandwidth the kernel reads the grid functions with.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cctk.h>
+#include <cctk_Schedule.h>
+
+#include "mock_cactus.hh"
+#include "Checksum.hh"
+#include "Shadow.hh"
+#include "Watch.hh"
+#include "public_rdwr_declare.h"
+
+namespace Read_Write_Diagnostics {
+  extern "C" int RDWR_pre_call(const cGH *,void *,const cFunctionData *,void *);
+  extern "C" int RDWR_post_call(const cGH *,void *,const cFunctionData *,void *);
+  extern "C" int RDWR_AddDiagnosticCalls(void);
+}
+
+using namespace Read_Write_Diagnostics;
+
+namespace {
+
+  struct options {
+    std::vector<int> sizes = {16,32,64,96};
+    std::vector<int> ghosts = {1,3};
+    std::vector<int> counts = {1,8,24};
+    std::vector<std::string> engines = {"xorfold","crc32c","mulmix"};
+    std::vector<std::string> modes = {"checksum","shadow"};
+    std::vector<std::string> kernels = {"cksum","regions","shadow","internet","hooks","varptr","clauses"};
+    int threads = 1;
+    double seconds = 0.2;
+  };
+  options opt;
+
+  std::vector<std::string> split(const char *list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while(std::getline(in,item,','))
+      if(!item.empty())
+        items.push_back(item);
+    return items;
+  }
+
+  std::vector<int> split_ints(const char *list) {
+    std::vector<int> values;
+    const std::vector<std::string> items = split(list);
+    for(auto i=items.begin();i != items.end();++i)
+      values.push_back(atoi(i->c_str()));
+    return values;
+  }
+
+  bool selected(const char *kernel) {
+    return std::find(opt.kernels.begin(),opt.kernels.end(),kernel) != opt.kernels.end();
+  }
+
+  double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Seconds per call of f: the best of three runs of at least
+  // opt.seconds/3 each
+  double measure(const std::function<void()>& f) {
+    f();
+    double best = 1e30;
+    for(int run=0;run<3;run++) {
+      long calls = 0;
+      const double start = now();
+      double t;
+      do {
+        f();
+        calls++;
+        t = now()-start;
+      } while(t < opt.seconds/3);
+      best = std::min(best,t/calls);
+    }
+    return best;
+  }
+
+  // units: the number of points (or calls) one call of the kernel covers,
+  // bytes: what it reads, 0 if that is not meaningful
+  void print(const char *kernel,const std::string& variant,int n,int g,int nv,
+             double t,double units,double bytes) {
+    printf("%-8s %-9s n=%-4d g=%d vars=%-3d %10.3f ns",kernel,variant.c_str(),n,g,nv,t/units*1e9);
+    if(bytes > 0)
+      printf(" %8.2f GB/s",bytes/t*1e-9);
+    printf("\n");
+    fflush(stdout);
+  }
+
+  // A routine that reads and writes the first nv variables. The hooks
+  // know routines by their cFunctionData, which Cactus never frees, so
+  // routines are created with new_routine() and live until the end.
+  struct routine {
+    std::vector<std::string> clauses;
+    std::vector<const char *> writes, reads;
+    cFunctionData attribute;
+
+    routine(const std::string& name,int nv) : clauses(2*nv) {
+      for(int v=0;v<nv;v++) {
+        clauses[v] = mock::variables[v].name + "(everywhere)";
+        clauses[nv+v] = mock::variables[v].name + "(everywhere)";
+      }
+      for(int v=0;v<nv;v++) {
+        writes.push_back(clauses[v].c_str());
+        reads.push_back(clauses[nv+v].c_str());
+      }
+      memset(&attribute,0,sizeof(attribute));
+      attribute.implementation = attribute.thorn = "BENCH";
+      attribute.routine = strdup((name+"_"+std::to_string(nv)).c_str());
+      attribute.where = "CCTK_EVOL";
+      attribute.n_WritesClauses = nv;
+      attribute.WritesClauses = writes.data();
+      attribute.n_ReadsClauses = nv;
+      attribute.ReadsClauses = reads.data();
+    }
+
+    void call(const cGH *cctkGH) {
+      RDWR_pre_call(cctkGH,0,&attribute,0);
+      mock::checked = 1;
+      RDWR_post_call(cctkGH,0,&attribute,0);
+    }
+  };
+  std::deque<routine> all_routines;
+
+  routine& new_routine(const std::string& name,int nv) {
+    all_routines.emplace_back(name,nv);
+    return all_routines.back();
+  }
+
+  void run(const cGH& gh,int nv) {
+    const int n = gh.cctk_lsh[0], g = gh.cctk_nghostzones[0];
+    const double npoints = double(gh.cctk_ash[0])*gh.cctk_ash[1]*gh.cctk_ash[2];
+    const double bytes = nv*npoints*sizeof(CCTK_REAL);
+
+    std::vector<cksum_job> jobs(nv);
+    std::vector<region_cksum_t> regions(nv);
+    for(int v=0;v<nv;v++)
+      jobs[v] = cksum_job{(unsigned long *)mock::variables[v].data[0],cksum_t(),0};
+
+    for(auto e=opt.engines.begin();e != opt.engines.end();++e) {
+      if(select_cksum_engine(e->c_str(),false) != *e)
+        continue;
+      if(selected("cksum")) {
+        const double t = measure([&]() { compute_cksums(&gh,jobs,opt.threads); });
+        print("cksum",*e,n,g,nv,t,nv*npoints,bytes);
+      }
+      // Engines that do not split are replaced for regions, skip them
+      if(selected("regions") && select_cksum_engine(e->c_str(),true) == *e) {
+        for(int v=0;v<nv;v++)
+          jobs[v].regions = &regions[v];
+        const double t = measure([&]() { compute_cksums(&gh,jobs,opt.threads); });
+        for(int v=0;v<nv;v++)
+          jobs[v].regions = 0;
+        print("regions",*e,n,g,nv,t,nv*npoints,bytes);
+      }
+      select_cksum_engine(e->c_str(),false);
+      if(selected("hooks")) {
+        for(auto m=opt.modes.begin();m != opt.modes.end();++m) {
+          // Only the checksum mode depends on the engine
+          if(*m != "checksum" && e != opt.engines.begin())
+            continue;
+          mock::param.write_detection = m->c_str();
+          routine& r = new_routine("evolve",nv);
+          const double t = measure([&]() { r.call(&gh); });
+          print("hooks",*m == "checksum" ? *e : *m,n,g,nv,t,nv*npoints,2*bytes);
+        }
+        mock::param.write_detection = "checksum";
+      }
+    }
+
+    if(selected("shadow")) {
+      const double t = measure([&]() {
+        shadow_reset();
+        for(int v=0;v<nv;v++) {
+          const CCTK_REAL *data = mock::variables[v].data[0];
+          const CCTK_REAL *copy = shadow_snapshot(data,size_t(npoints),size_t(1) << 40);
+          shadow_diff diff;
+          shadow_compare(&gh,copy,data,opt.threads,diff);
+        }
+      });
+      print("shadow","-",n,g,nv,t,nv*npoints,2*bytes);
+    }
+
+    if(selected("internet")) {
+      volatile unsigned short sink = 0;
+      const double t = measure([&]() {
+        for(int v=0;v<nv;v++)
+          sink ^= internet_checksum(mock::variables[v].data[0],size_t(npoints)*sizeof(CCTK_REAL));
+      });
+      print("internet","-",n,g,nv,t,nv*npoints,bytes);
+    }
+
+    if(selected("varptr")) {
+      routine& r = new_routine("varptr",nv);
+      RDWR_pre_call(&gh,0,&r.attribute,0);
+      const int nvars = mock::variables.size();
+      volatile long sink = 0;
+      const double t = measure([&]() {
+        for(int vi=0;vi<nvars;vi++)
+          sink += (long)RDWR_VarDataPtrI(&gh,0,vi);
+      });
+      mock::checked = 1;
+      RDWR_post_call(&gh,0,&r.attribute,0);
+      print("varptr","-",n,g,nv,t,nvars,0);
+    }
+
+    if(selected("clauses")) {
+      // The first call of a routine parses its clauses, later calls only
+      // check. Each measurement uses a fresh routine, and no variable has
+      // storage, so that the difference is not lost in the checksums.
+      static int fresh = 0;
+      mock::allocate(gh,0);
+      routine& steady = new_routine("steady",nv);
+      const double t_steady = measure([&]() { steady.call(&gh); });
+      const double t_first = measure([&]() {
+        new_routine("fresh"+std::to_string(fresh++),nv).call(&gh);
+      });
+      print("clauses","-",n,g,nv,std::max(0.0,t_first-t_steady),2*nv,0);
+    }
+  }
+}
+
+int main(int argc,char **argv) {
+  for(int i=1;i+1 < argc;i+=2) {
+    const std::string o = argv[i];
+    const char *arg = argv[i+1];
+    if(o == "-n") opt.sizes = split_ints(arg);
+    else if(o == "-g") opt.ghosts = split_ints(arg);
+    else if(o == "-v") opt.counts = split_ints(arg);
+    else if(o == "-e") opt.engines = split(arg);
+    else if(o == "-w") opt.modes = split(arg);
+    else if(o == "-k") opt.kernels = split(arg);
+    else if(o == "-t") opt.threads = atoi(arg);
+    else if(o == "-s") opt.seconds = atof(arg);
+    else {
+      fprintf(stderr,"unknown option %s\n",argv[i]);
+      return 1;
+    }
+  }
+  if(argc % 2 == 0) {
+    fprintf(stderr,"usage: %s [-n sizes] [-g ghosts] [-v counts] [-e engines] [-w modes] [-k kernels] [-t threads] [-s seconds]\n",argv[0]);
+    return 1;
+  }
+  mock::param.cksum_threads = opt.threads;
+  const int max_count = *std::max_element(opt.counts.begin(),opt.counts.end());
+  mock::add_group("BENCH::v",max_count,CCTK_GF,1);
+  RDWR_AddDiagnosticCalls();
+  for(auto n=opt.sizes.begin();n != opt.sizes.end();++n) {
+    for(auto g=opt.ghosts.begin();g != opt.ghosts.end();++g) {
+      cGH gh;
+      mock::setup_grid(gh,*n,*g);
+      for(auto nv=opt.counts.begin();nv != opt.counts.end();++nv) {
+        mock::allocate(gh,*nv);
+        run(gh,*nv);
+      }
+    }
+  }
+  return 0;
+}
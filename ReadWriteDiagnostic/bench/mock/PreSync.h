@@ -0,0 +1,10 @@
+#ifndef MOCK_PRESYNC_H
+#define MOCK_PRESYNC_H
+// Region masks, as in Carpet's PreSync.h
+#define WH_EVERYWHERE          0x7
+#define WH_INTERIOR            0x4
+#define WH_BOUNDARY            0x2
+#define WH_GHOSTS              0x1
+#define WH_NOWHERE             0x0
+#define WH_EXTERIOR            0x3
+#endif
@@ -0,0 +1,72 @@
+#ifndef MOCK_CCTK_H
+#define MOCK_CCTK_H
+// The subset of the Cactus flesh API that ReadWriteDiagnostic uses,
+// implemented in mock.cc
+#include <stddef.h>
+#include <stdlib.h>
+#include <assert.h>
+#ifdef __cplusplus
+#define restrict __restrict__
+#endif
+typedef double CCTK_REAL;
+typedef int CCTK_INT;
+typedef void *CCTK_POINTER;
+typedef const void *CCTK_POINTER_TO_CONST;
+typedef const char *CCTK_STRING;
+#define CCTK_GF 2
+#define CCTK_ARRAY 1
+#define CCTK_SCALAR 0
+typedef struct cGH {
+  int cctk_dim;
+  int cctk_iteration;
+  int cctk_gsh[3], cctk_lsh[3], cctk_ash[3], cctk_lbnd[3], cctk_ubnd[3];
+  int cctk_bbox[6];
+  int cctk_nghostzones[3];
+  int cctk_levfac[3];
+  int cctk_timefac;
+  CCTK_REAL cctk_time;
+} cGH;
+#define CCTK_GFINDEX3D(GH,i,j,k) ((i) + (GH)->cctk_ash[0]*((j) + (GH)->cctk_ash[1]*(k)))
+#ifdef __cplusplus
+extern "C" {
+#endif
+int CCTK_VarIndex(const char *);
+int CCTK_GroupIndex(const char *);
+char *CCTK_FullName(int);
+const char *CCTK_VarName(int);
+const char *CCTK_ImpFromVarI(int);
+char *CCTK_GroupNameFromVarI(int);
+char *CCTK_GroupName(int);
+int CCTK_GroupIndexFromVarI(int);
+int CCTK_FirstVarIndexI(int);
+int CCTK_NumVarsInGroupI(int);
+int CCTK_NumVars(void);
+int CCTK_NumGroups(void);
+int CCTK_GroupTypeFromVarI(int);
+int CCTK_VarTypeI(int);
+int CCTK_VarTypeSize(int);
+int CCTK_MaxTimeLevelsVI(int);
+int CCTK_ActiveTimeLevelsVI(const cGH *,int);
+void *CCTK_VarDataPtrI(const cGH *,int,int);
+int CCTK_IsFunctionAliased(const char *);
+int CCTK_SyncGroupsI(const cGH *,int,const int *);
+int CCTK_EnableGroupStorageI(const cGH *,int);
+int CCTK_MyProc(const cGH *);
+int CCTK_nProcs(const cGH *);
+double CCTK_RunTime(void);
+void CCTK_VError(int,const char *,const char *,const char *,const char *,...);
+void CCTK_VWarn(int,int,const char *,const char *,const char *,...);
+void CCTK_VInfo(const char *,const char *,...);
+int CCTK_Equals(const char *,const char *);
+int CCTK_RegexMatch(const char *,const char *,int,void *);
+#ifdef __cplusplus
+}
+#endif
+#define CCTK_THORNSTRING "ReadWriteDiagnostic"
+#define CCTK_VERROR(...) CCTK_VError(__LINE__,__FILE__,CCTK_THORNSTRING,__func__,__VA_ARGS__)
+#define CCTK_ERROR(m) CCTK_VERROR("%s",m)
+#define CCTK_VWARN(l,...) CCTK_VWarn(l,__LINE__,__FILE__,CCTK_THORNSTRING,__VA_ARGS__)
+#define CCTK_WARN(l,m) CCTK_VWARN(l,"%s",m)
+#define CCTK_VINFO(...) CCTK_VInfo(CCTK_THORNSTRING,__VA_ARGS__)
+#define CCTK_INFO(m) CCTK_VINFO("%s",m)
+#endif
@@ -0,0 +1,5 @@
+#ifndef MOCK_CCTK_ARGUMENTS_H
+#define MOCK_CCTK_ARGUMENTS_H
+#define CCTK_ARGUMENTS const cGH *cctkGH
+#define DECLARE_CCTK_ARGUMENTS const int *cctk_lsh = cctkGH->cctk_lsh; (void)cctk_lsh;
+#endif
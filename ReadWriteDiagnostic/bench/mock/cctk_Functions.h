@@ -0,0 +1,18 @@
+#ifndef MOCK_CCTK_FUNCTIONS_H
+#define MOCK_CCTK_FUNCTIONS_H
+#include <cctk.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+CCTK_INT Accelerator_RequireValidData(CCTK_POINTER_TO_CONST,const CCTK_INT *,const CCTK_INT *,const CCTK_INT *,CCTK_INT,CCTK_INT);
+CCTK_INT GetLocalComponent(CCTK_POINTER_TO_CONST);
+CCTK_INT GetMap(CCTK_POINTER_TO_CONST);
+CCTK_INT Carpet_GetValidRegion(CCTK_INT,CCTK_INT);
+CCTK_INT MoLQueryEvolvedRHS(CCTK_INT);
+void Carpet_SetValidRegion(CCTK_INT,CCTK_INT,CCTK_INT);
+CCTK_INT GetTimeLevel(CCTK_POINTER_TO_CONST);
+CCTK_INT RegisterScheduleWrapper(CCTK_INT (*)(CCTK_POINTER_TO_CONST,CCTK_POINTER,CCTK_POINTER,CCTK_POINTER),CCTK_INT (*)(CCTK_POINTER_TO_CONST,CCTK_POINTER,CCTK_POINTER,CCTK_POINTER));
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,34 @@
+#ifndef MOCK_CCTK_PARAMETERS_H
+#define MOCK_CCTK_PARAMETERS_H
+// The parameters of param.ccl, taken from mock::param so that the
+// benchmark can change them between runs
+#include "mock_cactus.hh"
+#define DECLARE_CCTK_PARAMETERS \
+  const char *zero_init = mock::param.zero_init; (void)zero_init; \
+  const CCTK_INT cksum_threads = mock::param.cksum_threads; (void)cksum_threads; \
+  const char *cksum_engine = mock::param.cksum_engine; (void)cksum_engine; \
+  const CCTK_INT reuse_cksums = mock::param.reuse_cksums; (void)reuse_cksums; \
+  const CCTK_INT localize_writes = mock::param.localize_writes; (void)localize_writes; \
+  const char *write_detection = mock::param.write_detection; (void)write_detection; \
+  const CCTK_INT shadow_budget_mb = mock::param.shadow_budget_mb; (void)shadow_budget_mb; \
+  const CCTK_INT trap_undeclared = mock::param.trap_undeclared; (void)trap_undeclared; \
+  const char *check_thorns = mock::param.check_thorns; (void)check_thorns; \
+  const char *check_routines = mock::param.check_routines; (void)check_routines; \
+  const char *check_bins = mock::param.check_bins; (void)check_bins; \
+  const char *skip_routines = mock::param.skip_routines; (void)skip_routines; \
+  const CCTK_INT sampling = mock::param.sampling; (void)sampling; \
+  const CCTK_INT sampling_initial_checks = mock::param.sampling_initial_checks; (void)sampling_initial_checks; \
+  const CCTK_INT sampling_max_interval = mock::param.sampling_max_interval; (void)sampling_max_interval; \
+  const CCTK_REAL sampling_overhead_budget = mock::param.sampling_overhead_budget; (void)sampling_overhead_budget; \
+  const CCTK_INT check_all_timelevels = mock::param.check_all_timelevels; (void)check_all_timelevels; \
+  const CCTK_INT elide_syncs = mock::param.elide_syncs; (void)elide_syncs; \
+  const CCTK_INT insert_syncs = mock::param.insert_syncs; (void)insert_syncs; \
+  const CCTK_INT verbosity = mock::param.verbosity; (void)verbosity; \
+  const char *log_sink = mock::param.log_sink; (void)log_sink; \
+  const char *log_file = mock::param.log_file; (void)log_file; \
+  const CCTK_INT overhead_table = mock::param.overhead_table; (void)overhead_table; \
+  const CCTK_INT overhead_varptr = mock::param.overhead_varptr; (void)overhead_varptr; \
+  const char *report_file = mock::param.report_file; (void)report_file; \
+  const char *clause_file = mock::param.clause_file; (void)clause_file; \
+  const char *record_schedule = mock::param.record_schedule; (void)record_schedule;
+#endif
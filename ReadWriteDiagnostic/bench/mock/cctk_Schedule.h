@@ -0,0 +1,15 @@
+#ifndef MOCK_CCTK_SCHEDULE_H
+#define MOCK_CCTK_SCHEDULE_H
+typedef struct {
+  const char *implementation;
+  const char *thorn;
+  const char *routine;
+  const char *where;
+  int n_SyncGroups;
+  int *SyncGroups;
+  int n_WritesClauses;
+  const char **WritesClauses;
+  int n_ReadsClauses;
+  const char **ReadsClauses;
+} cFunctionData;
+#endif
@@ -0,0 +1,3 @@
+#ifndef MOCK_CCTK_SYNC_H
+#define MOCK_CCTK_SYNC_H
+#endif
@@ -0,0 +1,182 @@
+// Implementation of the mock flesh and Carpet functions
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <cctk_Functions.h>
+#include <ScheduleWrapper.hh>
+
+#include "mock_cactus.hh"
+#include "PreSync.h"
+
+namespace mock {
+
+  parameters param;
+  std::vector<variable> variables;
+  std::vector<group> groups;
+  int rl = 0, map = 0, component = 0, timelevel = 0, checked = 0;
+
+  int add_group(const std::string& name,int nvars,int type,int ntl) {
+    std::vector<std::string> names;
+    const std::string imp = name.substr(0,name.find("::"));
+    for(int i=0;i<nvars;i++)
+      names.push_back(nvars == 1 ? name : imp + "::" + name.substr(name.find("::")+2) + "_" + std::to_string(i));
+    return add_group(name,names,type,sizeof(CCTK_REAL),ntl);
+  }
+
+  int add_group(const std::string& name,const std::vector<std::string>& names,
+                int type,int vartype_size,int ntl) {
+    const group g{name,int(variables.size()),int(names.size())};
+    for(auto n=names.begin();n != names.end();++n) {
+      variable v;
+      v.name = *n;
+      v.group = groups.size();
+      v.type = type;
+      v.vartype_size = vartype_size;
+      v.ntl = ntl;
+      v.data.assign(ntl,nullptr);
+      v.valid.assign(ntl,WH_NOWHERE);
+      variables.push_back(v);
+    }
+    groups.push_back(g);
+    return groups.size()-1;
+  }
+
+  void setup_grid(cGH& gh,int n,int ghosts) {
+    memset(&gh,0,sizeof(gh));
+    gh.cctk_dim = 3;
+    for(int d=0;d<3;d++) {
+      gh.cctk_gsh[d] = gh.cctk_lsh[d] = gh.cctk_ash[d] = n;
+      gh.cctk_nghostzones[d] = ghosts;
+      gh.cctk_levfac[d] = 1;
+      gh.cctk_bbox[2*d] = gh.cctk_bbox[2*d+1] = 1;
+    }
+    gh.cctk_timefac = 1;
+  }
+
+  void allocate(const cGH& gh,int nvars) {
+    const size_t n = size_t(gh.cctk_ash[0])*gh.cctk_ash[1]*gh.cctk_ash[2];
+    const size_t bytes = (n*sizeof(CCTK_REAL)+63)/64*64;
+    for(size_t vi=0;vi<variables.size();vi++) {
+      for(auto p=variables[vi].data.begin();p != variables[vi].data.end();++p) {
+        free(*p);
+        *p = nullptr;
+        if(int(vi) >= nvars || variables[vi].type != CCTK_GF ||
+           variables[vi].vartype_size != sizeof(CCTK_REAL))
+          continue;
+        *p = (CCTK_REAL *)aligned_alloc(64,bytes);
+        for(size_t i=0;i<n;i++)
+          (*p)[i] = 1.0 + i*1e-3;
+      }
+    }
+  }
+
+  int find_name(const char *name,bool is_group) {
+    if(is_group) {
+      for(size_t i=0;i<groups.size();i++)
+        if(strcasecmp(groups[i].name.c_str(),name) == 0)
+          return i;
+    } else {
+      for(size_t i=0;i<variables.size();i++)
+        if(strcasecmp(variables[i].name.c_str(),name) == 0)
+          return i;
+    }
+    return -1;
+  }
+}
+
+using namespace mock;
+
+extern "C" {
+
+  int CCTK_VarIndex(const char *name) { return find_name(name,false); }
+  int CCTK_GroupIndex(const char *name) { return find_name(name,true); }
+  char *CCTK_FullName(int vi) { return strdup(variables[vi].name.c_str()); }
+  const char *CCTK_VarName(int vi) { return variables[vi].name.c_str(); }
+  char *CCTK_GroupNameFromVarI(int vi) { return strdup(groups[variables[vi].group].name.c_str()); }
+  char *CCTK_GroupName(int gi) { return strdup(groups[gi].name.c_str()); }
+  int CCTK_GroupIndexFromVarI(int vi) { return variables[vi].group; }
+  int CCTK_FirstVarIndexI(int gi) { return groups[gi].first; }
+  int CCTK_NumVarsInGroupI(int gi) { return groups[gi].nvars; }
+  int CCTK_NumVars(void) { return variables.size(); }
+  int CCTK_NumGroups(void) { return groups.size(); }
+  int CCTK_GroupTypeFromVarI(int vi) { return variables[vi].type; }
+  // Variable types are represented by their size
+  int CCTK_VarTypeI(int vi) { return variables[vi].vartype_size; }
+  int CCTK_VarTypeSize(int type) { return type; }
+  int CCTK_MaxTimeLevelsVI(int vi) { return variables[vi].ntl; }
+  int CCTK_ActiveTimeLevelsVI(const cGH *,int vi) { return variables[vi].ntl; }
+
+  void *CCTK_VarDataPtrI(const cGH *,int tl,int vi) {
+    return tl < variables[vi].ntl ? variables[vi].data[tl] : nullptr;
+  }
+
+  int CCTK_IsFunctionAliased(const char *name) { return strcmp(name,"GetLocalComponent") == 0; }
+  int CCTK_SyncGroupsI(const cGH *,int n,const int *) { return n; }
+  int CCTK_EnableGroupStorageI(const cGH *,int) { return 0; }
+  int CCTK_MyProc(const cGH *) { return 0; }
+  int CCTK_nProcs(const cGH *) { return 1; }
+
+  double CCTK_RunTime(void) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void CCTK_VError(int line,const char *file,const char *,const char *,const char *fmt,...) {
+    va_list args;
+    va_start(args,fmt);
+    fprintf(stderr,"ERROR %s:%d: ",file,line);
+    vfprintf(stderr,fmt,args);
+    fputc('\n',stderr);
+    va_end(args);
+    abort();
+  }
+
+  void CCTK_VWarn(int level,int line,const char *file,const char *,const char *fmt,...) {
+    va_list args;
+    va_start(args,fmt);
+    fprintf(stderr,"WARNING[%d] %s:%d: ",level,file,line);
+    vfprintf(stderr,fmt,args);
+    fputc('\n',stderr);
+    va_end(args);
+    if(level == 0)
+      abort();
+  }
+
+  void CCTK_VInfo(const char *thorn,const char *fmt,...) {
+    va_list args;
+    va_start(args,fmt);
+    fprintf(stderr,"INFO (%s): ",thorn);
+    vfprintf(stderr,fmt,args);
+    fputc('\n',stderr);
+    va_end(args);
+  }
+
+  int CCTK_Equals(const char *a,const char *b) { return strcasecmp(a,b) == 0; }
+  int CCTK_RegexMatch(const char *,const char *,int,void *) { return 0; }
+
+  CCTK_INT GetLocalComponent(CCTK_POINTER_TO_CONST) { return component; }
+  CCTK_INT GetMap(CCTK_POINTER_TO_CONST) { return map; }
+  CCTK_INT GetTimeLevel(CCTK_POINTER_TO_CONST) { return timelevel; }
+  int GetRefinementLevel(const cGH *) { return rl; }
+  CCTK_INT Carpet_GetValidRegion(CCTK_INT vi,CCTK_INT tl) { return variables[vi].valid[tl]; }
+  void Carpet_SetValidRegion(CCTK_INT vi,CCTK_INT tl,CCTK_INT wh) { variables[vi].valid[tl] = wh; }
+  CCTK_INT MoLQueryEvolvedRHS(CCTK_INT) { return -1; }
+
+  CCTK_INT Accelerator_RequireValidData(CCTK_POINTER_TO_CONST,const CCTK_INT *,const CCTK_INT *,
+                                        const CCTK_INT *,CCTK_INT,CCTK_INT) {
+    return 0;
+  }
+
+  void CCTK_Checked_called() { checked++; }
+  void CCTK_Checked_reset() { checked = 0; }
+  int CCTK_Checked_get() { return checked; }
+}
+
+// The benchmark calls the hooks itself
+namespace Carpet {
+  extern "C" CCTK_INT Carpet_RegisterScheduleWrapper(func const,func const) { return 0; }
+  extern "C" CCTK_INT Carpet_UnRegisterScheduleWrapper(func const,func const) { return 0; }
+}
@@ -0,0 +1,82 @@
+#ifndef MOCK_CACTUS_HH
+#define MOCK_CACTUS_HH
+
+// A minimal stand-in for the Cactus flesh and Carpet, enough to run the
+// ReadWriteDiagnostic hooks outside of a Cactus configuration. Variables
+// are registered in groups and allocated on a single uniform grid.
+
+#include <string>
+#include <vector>
+#include <cctk.h>
+#include <cctk_Schedule.h>
+
+namespace mock {
+
+  struct variable {
+    std::string name;
+    int group, type, vartype_size, ntl;
+    std::vector<CCTK_REAL*> data;
+    std::vector<int> valid;
+  };
+
+  struct group {
+    std::string name;
+    int first, nvars;
+  };
+
+  // The defaults of param.ccl, except for verbosity, report_file and
+  // clause_file, which keep the benchmark quiet
+  struct parameters {
+    const char *zero_init = "";
+    CCTK_INT cksum_threads = 0;
+    const char *cksum_engine = "xorfold";
+    CCTK_INT reuse_cksums = 0;
+    CCTK_INT localize_writes = 0;
+    const char *write_detection = "checksum";
+    CCTK_INT shadow_budget_mb = 1024;
+    CCTK_INT trap_undeclared = 0;
+    const char *check_thorns = "";
+    const char *check_routines = "";
+    const char *check_bins = "";
+    const char *skip_routines = "";
+    CCTK_INT sampling = 0;
+    CCTK_INT sampling_initial_checks = 3;
+    CCTK_INT sampling_max_interval = 1024;
+    CCTK_REAL sampling_overhead_budget = 3.0;
+    CCTK_INT check_all_timelevels = 0;
+    CCTK_INT elide_syncs = 0;
+    CCTK_INT insert_syncs = 0;
+    CCTK_INT verbosity = 0;
+    const char *log_sink = "stdout";
+    const char *log_file = "rdwr_log";
+    CCTK_INT overhead_table = 20;
+    CCTK_INT overhead_varptr = 0;
+    const char *report_file = "";
+    const char *clause_file = "";
+    const char *record_schedule = "";
+  };
+
+  extern parameters param;
+  extern std::vector<variable> variables;
+  extern std::vector<group> groups;
+  extern int rl, map, component, timelevel, checked;
+
+  // Register a group of nvars variables called name_0, name_1, ...
+  // (or just name if nvars is 1). Returns the group index.
+  int add_group(const std::string& name,int nvars,int type,int ntl);
+
+  // Register a group with the given variables, of vartype_size bytes
+  int add_group(const std::string& name,const std::vector<std::string>& names,
+                int type,int vartype_size,int ntl);
+
+  // A cubic grid of n points with the given ghost width, all of whose
+  // faces are physical boundaries
+  void setup_grid(cGH& gh,int n,int ghosts);
+
+  // (Re)allocate and initialize the first nvars variables on the grid.
+  // The others, and all but real grid functions, have no storage, and
+  // are skipped by the hooks.
+  void allocate(const cGH& gh,int nvars);
+}
+
+#endif
@@ -0,0 +1,308 @@
+// Replays a schedule recorded with record_schedule (see Record.hh)
+// against the hooks, on the mock grid, and reports the time spent in
+// them. Between the hooks of a call, the variables the call was seen to
+// write are modified: one interior and one exterior point, depending on
+// the recorded region. Calls that were not checked repeat the writes of
+// the last checked call of their routine.
+//
+//   ./rdwr_replay [options] <record_schedule>.<rank>.txt
+//
+// Options:
+//   -r RUNS      replay the schedule this many times (default 3). The
+//                first run includes parsing the clauses.
+//   -e ENGINE    cksum_engine (default xorfold)
+//   -w MODE      write_detection (default checksum)
+//   -c 0|1       reuse_cksums (default 0)
+//   -l 0|1       localize_writes (default 0)
+//   -s 0|1       sampling (default 0)
+//   -t THREADS   cksum_threads (default 0)
+//   -n COUNT     routines to list with their hook time (default 10)
+//
+// All variables are allocated with the size of the largest component,
+// so the replay needs that much memory per real grid function and
+// timelevel.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cctk.h>
+#include <cctk_Schedule.h>
+
+#include "mock_cactus.hh"
+#include "PreSync.h"
+
+namespace Read_Write_Diagnostics {
+  extern "C" int RDWR_pre_call(const cGH *,void *,const cFunctionData *,void *);
+  extern "C" int RDWR_post_call(const cGH *,void *,const cFunctionData *,void *);
+  extern "C" int RDWR_AddDiagnosticCalls(void);
+}
+
+using namespace Read_Write_Diagnostics;
+
+namespace {
+
+  struct recorded_write {
+    int vi, tl, where;
+  };
+
+  struct recorded_routine {
+    std::vector<std::string> words;   // implementation, thorn, routine, where
+    std::vector<std::string> writes, reads;
+    std::vector<const char *> writes_p, reads_p;
+    std::vector<int> syncs;
+    cFunctionData attribute;
+    std::vector<recorded_write> last_writes;
+    double time;
+    long calls;
+  };
+
+  struct recorded_call {
+    int id, iteration, rl, map, component, timelevel, timefac;
+    int lsh[3], ash[3], lbnd[3], gsh[3], nghostzones[3], bbox[6], levfac[3];
+    std::vector<recorded_write> writes;
+    bool checked;
+  };
+
+  std::deque<recorded_routine> routines;
+  std::vector<recorded_call> calls;
+
+  int group_type(const std::string& type) {
+    if(type == "gf") return CCTK_GF;
+    if(type == "array") return CCTK_ARRAY;
+    return CCTK_SCALAR;
+  }
+
+  const char *word(const std::string& w) {
+    return w == "-" ? "" : w.c_str();
+  }
+
+  void read_clauses(std::istringstream& in,std::vector<std::string>& clauses) {
+    int n;
+    in >> n;
+    clauses.resize(n);
+    for(int i=0;i<n;i++)
+      in >> clauses[i];
+  }
+
+  void read_ints(std::istringstream& in,int *v,int n) {
+    for(int i=0;i<n;i++)
+      in >> v[i];
+  }
+
+  bool read_recording(const char *name) {
+    std::ifstream file(name);
+    std::string line;
+    if(!std::getline(file,line) || line != "rdwr-schedule 1") {
+      fprintf(stderr,"%s is not a schedule recording\n",name);
+      return false;
+    }
+    while(std::getline(file,line)) {
+      std::istringstream in(line);
+      std::string kind;
+      in >> kind;
+      if(kind == "group") {
+        int gi, size, ntl, nvars;
+        std::string gname, type;
+        in >> gi >> gname >> type >> size >> ntl >> nvars;
+        std::vector<std::string> names(nvars);
+        for(int i=0;i<nvars;i++)
+          in >> names[i];
+        if(mock::add_group(gname,names,group_type(type),size,ntl) != gi) {
+          fprintf(stderr,"%s: groups out of order\n",name);
+          return false;
+        }
+      } else if(kind == "routine") {
+        routines.emplace_back();
+        recorded_routine& r = routines.back();
+        int id;
+        in >> id;
+        r.words.resize(4);
+        for(int i=0;i<4;i++)
+          in >> r.words[i];
+        read_clauses(in,r.writes);
+        read_clauses(in,r.reads);
+        int n;
+        in >> n;
+        r.syncs.resize(n);
+        read_ints(in,r.syncs.data(),n);
+        for(auto c=r.writes.begin();c != r.writes.end();++c)
+          r.writes_p.push_back(c->c_str());
+        for(auto c=r.reads.begin();c != r.reads.end();++c)
+          r.reads_p.push_back(c->c_str());
+        memset(&r.attribute,0,sizeof(r.attribute));
+        r.attribute.implementation = word(r.words[0]);
+        r.attribute.thorn = word(r.words[1]);
+        r.attribute.routine = word(r.words[2]);
+        r.attribute.where = word(r.words[3]);
+        r.attribute.n_WritesClauses = r.writes_p.size();
+        r.attribute.WritesClauses = r.writes_p.data();
+        r.attribute.n_ReadsClauses = r.reads_p.size();
+        r.attribute.ReadsClauses = r.reads_p.data();
+        r.attribute.n_SyncGroups = r.syncs.size();
+        r.attribute.SyncGroups = r.syncs.data();
+        if(id != int(routines.size())-1) {
+          fprintf(stderr,"%s: routines out of order\n",name);
+          return false;
+        }
+      } else if(kind == "call") {
+        recorded_call c;
+        in >> c.id >> c.iteration >> c.rl >> c.map >> c.component >> c.timelevel >> c.timefac;
+        read_ints(in,c.lsh,3);
+        read_ints(in,c.ash,3);
+        read_ints(in,c.lbnd,3);
+        read_ints(in,c.gsh,3);
+        read_ints(in,c.nghostzones,3);
+        read_ints(in,c.bbox,6);
+        read_ints(in,c.levfac,3);
+        c.checked = false;
+        calls.push_back(c);
+      } else if(kind == "write" && !calls.empty()) {
+        recorded_write w;
+        in >> w.vi >> w.tl >> w.where;
+        calls.back().writes.push_back(w);
+      } else if(kind == "done" && !calls.empty()) {
+        int checked;
+        in >> checked;
+        calls.back().checked = checked != 0;
+      }
+    }
+    return true;
+  }
+
+  void set_grid(cGH& gh,const recorded_call& c) {
+    gh.cctk_iteration = c.iteration;
+    gh.cctk_timefac = c.timefac;
+    for(int d=0;d<3;d++) {
+      gh.cctk_lsh[d] = c.lsh[d];
+      gh.cctk_ash[d] = c.ash[d];
+      gh.cctk_lbnd[d] = c.lbnd[d];
+      gh.cctk_gsh[d] = c.gsh[d];
+      gh.cctk_nghostzones[d] = c.nghostzones[d];
+      gh.cctk_levfac[d] = c.levfac[d];
+    }
+    for(int f=0;f<6;f++)
+      gh.cctk_bbox[f] = c.bbox[f];
+    mock::rl = c.rl;
+    mock::map = c.map;
+    mock::component = c.component;
+    mock::timelevel = c.timelevel;
+  }
+
+  // What the routine would have done
+  void apply_writes(const cGH& gh,const std::vector<recorded_write>& writes) {
+    const int interior = CCTK_GFINDEX3D(&gh,gh.cctk_lsh[0]/2,gh.cctk_lsh[1]/2,gh.cctk_lsh[2]/2);
+    for(auto w=writes.begin();w != writes.end();++w) {
+      mock::variable& v = mock::variables[w->vi];
+      if(w->tl >= v.ntl || v.data[w->tl] == nullptr)
+        continue;
+      if((w->where & WH_INTERIOR) != 0)
+        v.data[w->tl][interior] += 1;
+      if((w->where & WH_EXTERIOR) != 0)
+        v.data[w->tl][0] += 1;
+    }
+  }
+
+  double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Returns the time spent in the hooks
+  double replay(cGH& gh) {
+    double total = 0;
+    for(auto c=calls.begin();c != calls.end();++c) {
+      recorded_routine& r = routines[c->id];
+      if(c->checked)
+        r.last_writes = c->writes;
+      set_grid(gh,*c);
+      const double t0 = now();
+      RDWR_pre_call(&gh,0,&r.attribute,0);
+      const double t1 = now();
+      apply_writes(gh,c->checked ? c->writes : r.last_writes);
+      mock::checked = 1;
+      const double t2 = now();
+      RDWR_post_call(&gh,0,&r.attribute,0);
+      const double t = (t1-t0)+(now()-t2);
+      r.time += t;
+      r.calls++;
+      total += t;
+    }
+    return total;
+  }
+}
+
+int main(int argc,char **argv) {
+  int runs = 3, top = 10;
+  int i;
+  for(i=1;i+1 < argc;i+=2) {
+    const std::string o = argv[i];
+    const char *arg = argv[i+1];
+    if(o == "-r") runs = atoi(arg);
+    else if(o == "-e") mock::param.cksum_engine = arg;
+    else if(o == "-w") mock::param.write_detection = arg;
+    else if(o == "-c") mock::param.reuse_cksums = atoi(arg);
+    else if(o == "-l") mock::param.localize_writes = atoi(arg);
+    else if(o == "-s") mock::param.sampling = atoi(arg);
+    else if(o == "-t") mock::param.cksum_threads = atoi(arg);
+    else if(o == "-n") top = atoi(arg);
+    else break;
+  }
+  if(i != argc-1) {
+    fprintf(stderr,"usage: %s [-r runs] [-e engine] [-w mode] [-c 0|1] [-l 0|1] [-s 0|1] [-t threads] [-n count] recording\n",argv[0]);
+    return 1;
+  }
+  if(!read_recording(argv[i]))
+    return 1;
+
+  // Every variable gets the storage of the largest component
+  size_t max_points = 1;
+  std::set<int> iterations;
+  for(auto c=calls.begin();c != calls.end();++c) {
+    max_points = std::max(max_points,size_t(c->ash[0])*c->ash[1]*c->ash[2]);
+    iterations.insert(c->iteration);
+  }
+  cGH gh;
+  memset(&gh,0,sizeof(gh));
+  gh.cctk_dim = 3;
+  gh.cctk_ash[0] = max_points;
+  gh.cctk_ash[1] = gh.cctk_ash[2] = 1;
+  mock::allocate(gh,mock::variables.size());
+  long nreal = 0;
+  for(auto v=mock::variables.begin();v != mock::variables.end();++v)
+    if(!v->data.empty() && v->data[0] != nullptr)
+      nreal += v->ntl;
+  printf("%zu calls of %zu routines in %zu iterations, %ld timelevels of %zu points (%.1f GB)\n",
+         calls.size(),routines.size(),iterations.size(),nreal,max_points,
+         nreal*max_points*sizeof(CCTK_REAL)*1e-9);
+
+  RDWR_AddDiagnosticCalls();
+  for(int run=0;run<runs;run++) {
+    for(auto r=routines.begin();r != routines.end();++r) {
+      r->time = 0;
+      r->calls = 0;
+    }
+    const double t = replay(gh);
+    printf("run %d: %.3f ms in the hooks, %.3f ms per iteration, %.2f us per call\n",
+           run+1,t*1e3,t/iterations.size()*1e3,t/calls.size()*1e6);
+    fflush(stdout);
+  }
+
+  std::vector<const recorded_routine *> order;
+  for(auto r=routines.begin();r != routines.end();++r)
+    order.push_back(&*r);
+  std::sort(order.begin(),order.end(),[](const recorded_routine *a,const recorded_routine *b) {
+    return a->time > b->time;
+  });
+  printf("%10s %8s  routine (last run)\n","ms","calls");
+  for(int n=0;n<top && n < int(order.size());n++)
+    printf("%10.3f %8ld  %s::%s\n",order[n]->time*1e3,order[n]->calls,
+           order[n]->words[1].c_str(),order[n]->words[2].c_str());
+  return 0;
+}
@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <cctk.h>
+#include <cctk_Functions.h>
+#include "PreSync.h"
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Checksum.hh"
+#include "Log.hh"
+
+namespace Read_Write_Diagnostics {
+
+  extern "C" int GetRefinementLevel(const cGH*);
+
+  // Each point is rotated left by (bytes * (cc % bytes)) bits before it
+  // is folded into the checksum. Since rotation distributes over xor we
+  // keep one accumulator per rotation (a "lane", selected by cc % bytes),
+  // fold whole spans of a row into the lanes with plain xors, and only
+  // apply the rotations once per region at the end.
+  const int bytes = sizeof(unsigned long);
+  static_assert(sizeof(unsigned long) == 8,"lane layout assumes 64 bit words");
+
+  inline void fold_span(const unsigned long *restrict ldata,ptrdiff_t b,ptrdiff_t e,
+                        unsigned long *restrict lanes) {
+    // Scalar head, until the span is aligned to the lane pattern
+    for(;b < e && (b % bytes) != 0;++b)
+      lanes[b % bytes] ^= ldata[b];
+    const ptrdiff_t e8 = b + ((e - b) / bytes) * bytes;
+#if defined(__AVX512F__)
+    __m512i v = _mm512_loadu_si512((const void *)lanes);
+    for(;b < e8;b += bytes)
+      v = _mm512_xor_si512(v,_mm512_loadu_si512((const void *)(ldata+b)));
+    _mm512_storeu_si512((void *)lanes,v);
+#elif defined(__AVX2__)
+    __m256i lo = _mm256_loadu_si256((const __m256i *)lanes);
+    __m256i hi = _mm256_loadu_si256((const __m256i *)(lanes+4));
+    for(;b < e8;b += bytes) {
+      lo = _mm256_xor_si256(lo,_mm256_loadu_si256((const __m256i *)(ldata+b)));
+      hi = _mm256_xor_si256(hi,_mm256_loadu_si256((const __m256i *)(ldata+b+4)));
+    }
+    _mm256_storeu_si256((__m256i *)lanes,lo);
+    _mm256_storeu_si256((__m256i *)(lanes+4),hi);
+#else
+    for(;b < e8;b += bytes)
+      for(int n=0;n<bytes;n++)
+        lanes[n] ^= ldata[b+n];
+#endif
+    // Scalar tail
+    for(;b < e;++b)
+      lanes[b % bytes] ^= ldata[b];
+  }
+
+  // Apply the per-lane rotation and combine the lanes.
+  // Lane 0 is not rotated (the original per-point code relied on a shift
+  // by the full word width, which leaves the value unchanged on x86).
+  inline unsigned long fold_lanes(const unsigned long *lanes) {
+    unsigned long c = lanes[0];
+    for(int n=1;n<bytes;n++) {
+      const int m = bytes-n;
+      c ^= (lanes[n] << (bytes*n))|(lanes[n] >> (bytes*m));
+    }
+    return c;
+  }
+
+  // Variables checksummed together in one pass over a plane. They share
+  // the index arithmetic and region classification of every row, and
+  // few enough streams are read at once for the hardware prefetchers.
+  const int batch_size = 8;
+
+  // Fold the k-plane of n variables into their in and out lanes.
+  inline void fold_plane(const cGH *cctkGH,const unsigned long *const *ldata,int n,int k,
+                         unsigned long (*in)[bytes],unsigned long (*out)[bytes]) {
+    const int *cctk_nghostzones = cctkGH->cctk_nghostzones;
+    const int *cctk_lsh = cctkGH->cctk_lsh;
+    // Interior span [i0,i1) of a row in x. It is empty if the
+    // ghost zones of both sides overlap.
+    const int i0 = std::min(cctk_nghostzones[0],cctk_lsh[0]);
+    const int i1 = std::max(i0,cctk_lsh[0]-cctk_nghostzones[0]);
+    const bool inz = (cctk_nghostzones[2] <= k && k < cctk_lsh[2]-cctk_nghostzones[2]);
+    for(int j=0;j<cctk_lsh[1];j++) {
+      const bool iny = (cctk_nghostzones[1] <= j && j < cctk_lsh[1]-cctk_nghostzones[1]);
+      // Rows outside the interior in y or z are a single exterior span
+      const int b0 = (iny && inz) ? i0 : cctk_lsh[0];
+      const int b1 = (iny && inz) ? i1 : cctk_lsh[0];
+      const ptrdiff_t cc = CCTK_GFINDEX3D(cctkGH,0,j,k);
+      for(int m=0;m<n;m++) {
+        fold_span(ldata[m],cc,cc+b0,out[m]);
+        fold_span(ldata[m],cc+b0,cc+b1,in[m]);
+        fold_span(ldata[m],cc+b1,cc+cctk_lsh[0],out[m]);
+      }
+    }
+  }
+
+  // Checksum engines. Every engine digests a span [b,e) of a row into one
+  // word that depends on the position of the span, so the digests of all
+  // spans of a region can be combined with xor, in any order and across
+  // threads. For engines that split, the digest of a span is the xor of
+  // the digests of its points, so it does not depend on how a row is
+  // split into spans either, and region checksums (localize_writes) add
+  // up to the plain ones. crc32c chains the points of a span and does
+  // not split.
+  struct cksum_engine {
+    const char *name;
+    bool strong;          // changes cancel out only by chance
+    bool splits;          // see above
+    bool (*available)();
+    unsigned long (*span)(const unsigned long *ldata,ptrdiff_t b,ptrdiff_t e);
+  };
+
+  bool always_available() { return true; }
+
+  // The xor fold: fastest, but changes cancel out if the same bits flip
+  // in two words a multiple of 8 points apart
+  unsigned long xorfold_span(const unsigned long *ldata,ptrdiff_t b,ptrdiff_t e) {
+    unsigned long lanes[bytes] = {0};
+    fold_span(ldata,b,e,lanes);
+    return fold_lanes(lanes);
+  }
+
+#if defined(__x86_64__)
+  bool crc32c_available() { return __builtin_cpu_supports("sse4.2"); }
+
+  // SSE4.2 CRC32C, with three independent chains to hide the latency
+  // of the crc32 instruction, seeded with the position of the span
+  __attribute__((target("sse4.2")))
+  unsigned long crc32c_span(const unsigned long *ldata,ptrdiff_t b,ptrdiff_t e) {
+    uint64_t c0 = uint32_t(b), c1 = uint32_t(uint64_t(b) >> 32) ^ 0x9e3779b9, c2 = 0x85ebca6b;
+    ptrdiff_t i = b;
+    for(;i+3 <= e;i+=3) {
+      c0 = _mm_crc32_u64(c0,ldata[i]);
+      c1 = _mm_crc32_u64(c1,ldata[i+1]);
+      c2 = _mm_crc32_u64(c2,ldata[i+2]);
+    }
+    for(;i < e;i++)
+      c0 = _mm_crc32_u64(c0,ldata[i]);
+    return ((c1 << 32) | c0) ^ (c2 * 0x9e3779b97f4a7c15UL);
+  }
+#else
+  bool crc32c_available() { return false; }
+  unsigned long crc32c_span(const unsigned long *,ptrdiff_t,ptrdiff_t) { return 0; }
+#endif
+
+  // Finalizer of MurmurHash3, a bijection of 64 bit words
+  inline unsigned long mix64(unsigned long x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdUL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53UL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  // Xor of the mixed words, each salted with its index. Every point
+  // contributes independently, so the loop vectorizes, and the digest
+  // of a span is the xor of those of its parts.
+  unsigned long mulmix_span(const unsigned long *ldata,ptrdiff_t b,ptrdiff_t e) {
+    unsigned long h = 0;
+    for(ptrdiff_t i=b;i<e;i++)
+      h ^= mix64(ldata[i] ^ (unsigned long)i * 0x9e3779b97f4a7c15UL);
+    return h;
+  }
+
+  const cksum_engine engines[] = {
+    {"xorfold",false,true,always_available,xorfold_span},
+    {"crc32c",true,false,crc32c_available,crc32c_span},
+    {"mulmix",true,true,always_available,mulmix_span}
+  };
+  const int num_engines = sizeof(engines)/sizeof(engines[0]);
+  const cksum_engine *engine = &engines[0];
+
+  // Throughput of an engine in GB/s on a buffer that does not fit in cache
+  double benchmark(const cksum_engine& e) {
+    static std::vector<unsigned long> buffer;
+    if(buffer.empty()) {
+      buffer.resize(size_t(1) << 21);
+      for(size_t i=0;i<buffer.size();i++)
+        buffer[i] = mix64(i);
+    }
+    double best = 1e30;
+    volatile unsigned long sink = 0;
+    for(int rep=0;rep<3;rep++) {
+      auto start = std::chrono::steady_clock::now();
+      sink ^= e.span(buffer.data(),0,buffer.size());
+      const double t = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      best = std::min(best,t);
+    }
+    return buffer.size()*sizeof(unsigned long)/best*1e-9;
+  }
+
+  const char *select_cksum_engine(const char *name,bool regions) {
+    const bool automatic = strcmp(name,"auto") == 0;
+    double fastest = 0;
+    engine = &engines[0];
+    for(int n=0;n<num_engines;n++) {
+      const cksum_engine& e = engines[n];
+      if(!e.available())
+        continue;
+      if(automatic) {
+        const double speed = benchmark(e);
+        RDWR_LOG(LOG_INFO) << "RDWR: checksum engine " << e.name << ": " << speed << " GB/s";
+        if(e.strong && (e.splits || !regions) && speed > fastest) {
+          fastest = speed;
+          engine = &e;
+        }
+      } else if(strcmp(name,e.name) == 0) {
+        if(regions && !e.splits) {
+          // The strong engine that splits
+          engine = &engines[2];
+          RDWR_LOG(LOG_WARNING) << "RDWR: checksum engine " << name << " cannot checksum regions, using " << engine->name;
+          return engine->name;
+        }
+        engine = &e;
+        return e.name;
+      }
+    }
+    if(!automatic) {
+      RDWR_LOG(LOG_WARNING) << "RDWR: checksum engine " << name << " is not available, using " << engine->name;
+    }
+    return engine->name;
+  }
+
+  // Digests of the interior and exterior of the k-plane of n <= batch_size
+  // variables
+  inline void digest_plane(const cGH *cctkGH,const unsigned long *const *ldata,int n,int k,
+                           unsigned long *pin,unsigned long *pout) {
+    if(engine == &engines[0]) {
+      // Fold whole planes into the lanes, rotating only once
+      unsigned long in[batch_size][bytes] = {{0}}, out[batch_size][bytes] = {{0}};
+      fold_plane(cctkGH,ldata,n,k,in,out);
+      for(int m=0;m<n;m++) {
+        pin[m] = fold_lanes(in[m]);
+        pout[m] = fold_lanes(out[m]);
+      }
+      return;
+    }
+    const int *cctk_nghostzones = cctkGH->cctk_nghostzones;
+    const int *cctk_lsh = cctkGH->cctk_lsh;
+    const int i0 = std::min(cctk_nghostzones[0],cctk_lsh[0]);
+    const int i1 = std::max(i0,cctk_lsh[0]-cctk_nghostzones[0]);
+    const bool inz = (cctk_nghostzones[2] <= k && k < cctk_lsh[2]-cctk_nghostzones[2]);
+    for(int m=0;m<n;m++)
+      pin[m] = pout[m] = 0;
+    for(int j=0;j<cctk_lsh[1];j++) {
+      const bool iny = (cctk_nghostzones[1] <= j && j < cctk_lsh[1]-cctk_nghostzones[1]);
+      const ptrdiff_t cc = CCTK_GFINDEX3D(cctkGH,0,j,k);
+      for(int m=0;m<n;m++) {
+        if(!(iny && inz)) {
+          pout[m] ^= engine->span(ldata[m],cc,cc+cctk_lsh[0]);
+          continue;
+        }
+        pout[m] ^= engine->span(ldata[m],cc,cc+i0);
+        pin[m] ^= engine->span(ldata[m],cc+i0,cc+i1);
+        pout[m] ^= engine->span(ldata[m],cc+i1,cc+cctk_lsh[0]);
+      }
+    }
+  }
+
+  int region_of(int x,int g,int n) {
+    const int x0 = std::min(g,n);
+    const int x1 = std::max(x0,n-g);
+    return x < x0 ? 0 : (x < x1 ? 1 : 2);
+  }
+
+  // Same as fold_plane, but also fold into the region checksum.
+  // Rows are always split in x, since the blocks need the x regions of
+  // exterior rows as well.
+  void fold_plane_regions(const cGH *cctkGH,const unsigned long *ldata,int k,
+                          region_cksum_t& r) {
+    const int *cctk_nghostzones = cctkGH->cctk_nghostzones;
+    const int *cctk_lsh = cctkGH->cctk_lsh;
+    const int i0 = std::min(cctk_nghostzones[0],cctk_lsh[0]);
+    const int i1 = std::max(i0,cctk_lsh[0]-cctk_nghostzones[0]);
+    const int kz = region_of(k,cctk_nghostzones[2],cctk_lsh[2]);
+    unsigned long block[9] = {0};
+    // One buffer per thread, reused for every plane and variable
+    static thread_local std::vector<unsigned long> xplane;
+    xplane.assign(cctk_lsh[0],0);
+    unsigned long zplane = 0;
+    for(int j=0;j<cctk_lsh[1];j++) {
+      const int jy = region_of(j,cctk_nghostzones[1],cctk_lsh[1]);
+      const ptrdiff_t cc = CCTK_GFINDEX3D(cctkGH,0,j,k);
+      const int b[4] = {0,i0,i1,cctk_lsh[0]};
+      unsigned long row = 0;
+      for(int ix=0;ix<3;ix++) {
+        const unsigned long w = engine->span(ldata,cc+b[ix],cc+b[ix+1]);
+        block[jy*3+ix] ^= w;
+        row ^= w;
+      }
+      for(int i=0;i<cctk_lsh[0];i++)
+        xplane[i] ^= ldata[cc+i];
+#pragma omp atomic
+      r.plane[1][j] ^= row;
+      zplane ^= row;
+    }
+    r.plane[2][k] ^= zplane;
+    for(int n=0;n<9;n++) {
+#pragma omp atomic
+      r.block[kz*9+n] ^= block[n];
+    }
+    for(int i=0;i<cctk_lsh[0];i++) {
+#pragma omp atomic
+      r.plane[0][i] ^= xplane[i];
+    }
+  }
+
+  int classify_blocks(const cGH *cctkGH,const bool changed[27]) {
+    int where = 0;
+    for(int n=0;n<27;n++) {
+      if(!changed[n])
+        continue;
+      const int bi[3] = {n%3,n/3%3,n/9};
+      bool physical = false;
+      for(int d=0;d<3;d++) {
+        if(bi[d] != 1 && cctkGH->cctk_bbox[2*d+bi[d]/2])
+          physical = true;
+      }
+      if(n == block_index(1,1,1))
+        where |= WH_INTERIOR;
+      else if(physical)
+        where |= WH_BOUNDARY;
+      else
+        where |= WH_GHOSTS;
+    }
+    return where;
+  }
+
+  bool diff_regions(const cGH *cctkGH,const region_cksum_t& before,
+                    const region_cksum_t& after,write_extent& ext) {
+    const int *cctk_nghostzones = cctkGH->cctk_nghostzones;
+    const int *cctk_lsh = cctkGH->cctk_lsh;
+    int blo[3] = {3,3,3}, bhi[3] = {-1,-1,-1};
+    bool changed[27];
+    for(int n=0;n<27;n++) {
+      changed[n] = before.block[n] != after.block[n];
+      if(!changed[n])
+        continue;
+      const int bi[3] = {n%3,n/3%3,n/9};
+      for(int d=0;d<3;d++) {
+        blo[d] = std::min(blo[d],bi[d]);
+        bhi[d] = std::max(bhi[d],bi[d]);
+      }
+    }
+    ext.where = classify_blocks(cctkGH,changed);
+    if(ext.where == 0)
+      return false;
+    for(int d=0;d<3;d++) {
+      const std::vector<unsigned long>& pb = before.plane[d];
+      const std::vector<unsigned long>& pa = after.plane[d];
+      ext.lo[d] = cctk_lsh[d];
+      ext.hi[d] = -1;
+      // Plane digests from a different grid shape can't be compared
+      const int np = (int(pb.size()) == cctk_lsh[d] && int(pa.size()) == cctk_lsh[d]) ? cctk_lsh[d] : 0;
+      for(int x=0;x<np;x++) {
+        if(pb[x] != pa[x]) {
+          ext.lo[d] = std::min(ext.lo[d],x);
+          ext.hi[d] = x;
+        }
+      }
+      if(ext.hi[d] < 0) {
+        // The changes cancelled out in the plane digests of this
+        // axis (or there are none), use the extent of the changed blocks.
+        const int g = cctk_nghostzones[d];
+        const int x0 = std::min(g,cctk_lsh[d]);
+        const int x1 = std::max(x0,cctk_lsh[d]-g);
+        const int b[4] = {0,x0,x1,cctk_lsh[d]};
+        ext.lo[d] = b[blo[d]];
+        ext.hi[d] = b[bhi[d]+1]-1;
+      }
+    }
+    return true;
+  }
+
+  cksum_t compute_cksum(const cGH *cctkGH,const unsigned long *ldata,int vi) {
+    cksum_t c;
+    #if 0
+    // When is the data supposed to become valid?
+    if (CCTK_IsFunctionAliased("Accelerator_RequireValidData")) {
+      bool on_device = 0;
+      int rl = GetRefinementLevel(cctkGH);
+      int tl = 0;
+      Accelerator_RequireValidData(cctkGH, &vi, &rl, &tl, 1, on_device);
+    }
+    #endif
+    for(int k=0;k<cctkGH->cctk_lsh[2];k++) {
+      unsigned long pin, pout;
+      digest_plane(cctkGH,&ldata,1,k,&pin,&pout);
+      c.in ^= pin;
+      c.out ^= pout;
+    }
+    return c;
+  }
+
+  void compute_cksums(const cGH *cctkGH,std::vector<cksum_job>& jobs,int nthreads) {
+    const ptrdiff_t nk = cctkGH->cctk_lsh[2];
+    // Jobs with region checksums are folded one at a time, the others
+    // in batches of up to batch_size variables. Kept across calls to
+    // avoid reallocating them.
+    static std::vector<size_t> single, batched;
+    single.clear();
+    batched.clear();
+    for(size_t n=0;n<jobs.size();n++) {
+      cksum_job& job = jobs[n];
+      job.cksum = cksum_t();
+      if(job.regions != 0) {
+        region_cksum_t& r = *job.regions;
+        for(int b=0;b<27;b++)
+          r.block[b] = 0;
+        for(int d=0;d<3;d++)
+          r.plane[d].assign(cctkGH->cctk_lsh[d],0);
+        single.push_back(n);
+      } else {
+        batched.push_back(n);
+      }
+    }
+    const ptrdiff_t nsingle = single.size();
+    const ptrdiff_t nbatches = (batched.size()+batch_size-1)/batch_size;
+    const ptrdiff_t nwork = nk*(nsingle+nbatches);
+#ifdef _OPENMP
+    if(nthreads <= 0)
+      nthreads = omp_get_max_threads();
+#else
+    nthreads = 1;
+#endif
+    // Work items are (single job or batch, k-plane) pairs, in memory
+    // order. Each item produces a partial checksum of its jobs, and since
+    // the checksum is a plain xor of span digests, the partials are
+    // xor-reduced into it.
+#pragma omp parallel for schedule(static) num_threads(nthreads) if(nthreads > 1 && nwork > 1)
+    for(ptrdiff_t w=0;w<nwork;w++) {
+      const ptrdiff_t item = w / nk;
+      const int k = w % nk;
+      if(item < nsingle) {
+        cksum_job& job = jobs[single[item]];
+        fold_plane_regions(cctkGH,job.ldata,k,*job.regions);
+        continue;
+      }
+      const size_t first = (item-nsingle)*batch_size;
+      const int n = std::min(size_t(batch_size),batched.size()-first);
+      const unsigned long *ldata[batch_size];
+      for(int m=0;m<n;m++)
+        ldata[m] = jobs[batched[first+m]].ldata;
+      unsigned long pin[batch_size], pout[batch_size];
+      digest_plane(cctkGH,ldata,n,k,pin,pout);
+      for(int m=0;m<n;m++) {
+        cksum_job& job = jobs[batched[first+m]];
+#pragma omp atomic
+        job.cksum.in ^= pin[m];
+#pragma omp atomic
+        job.cksum.out ^= pout[m];
+      }
+    }
+    // The interior is a single block, everything else is exterior
+    for(auto j=jobs.begin();j != jobs.end();++j) {
+      if(j->regions == 0)
+        continue;
+      for(int n=0;n<27;n++) {
+        if(n == block_index(1,1,1))
+          j->cksum.in ^= j->regions->block[n];
+        else
+          j->cksum.out ^= j->regions->block[n];
+      }
+    }
+  }
+}
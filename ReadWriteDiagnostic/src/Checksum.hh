@@ -0,0 +1,80 @@
+#ifndef RDWR_CHECKSUM_HH
+#define RDWR_CHECKSUM_HH
+
+#include <cctk.h>
+#include <iostream>
+#include <vector>
+
+namespace Read_Write_Diagnostics {
+
+  // Checksum of a grid function, split into the interior
+  // and everything else (boundary and ghost zones).
+  struct cksum_t {
+    unsigned long in, out;
+    cksum_t() : in(0), out(0) {}
+  };
+
+  inline bool operator==(const cksum_t& c1,const cksum_t& c2) {
+    return c1.in == c2.in && c1.out == c2.out;
+  }
+  inline bool operator!=(const cksum_t& c1,const cksum_t& c2) {
+    return c1.in != c2.in || c1.out != c2.out;
+  }
+  inline std::ostream& operator<<(std::ostream& out,const cksum_t& c) {
+    return out << std::hex << c.in << ":" << c.out << std::dec;
+  }
+
+  cksum_t compute_cksum(const cGH *cctkGH,const unsigned long *ldata,int vi);
+
+  // Select the checksum engine: "xorfold", "crc32c" (SSE4.2), "mulmix",
+  // or "auto" for the fastest of the strong engines, crc32c and mulmix,
+  // measured on this host. With regions, crc32c is not used, since its
+  // region checksums would differ from the plain ones. Returns the name
+  // of the engine in use. Must not change while checksums are kept.
+  const char *select_cksum_engine(const char *name,bool regions);
+
+  // Finer grained checksum of a grid function, built in the same pass
+  // as cksum_t. Level 1 splits every axis into lower exterior, interior
+  // and upper exterior, giving 3x3x3 blocks; block 13 is the interior.
+  // Level 2 holds one digest per plane of every axis, which localizes
+  // writes to a bounding box.
+  struct region_cksum_t {
+    unsigned long block[27];
+    std::vector<unsigned long> plane[3];
+    region_cksum_t() : block() {}
+  };
+
+  inline int block_index(int ix,int jy,int kz) { return (kz*3+jy)*3+ix; }
+
+  // The part of a grid function in which two region checksums differ
+  struct write_extent {
+    int lo[3], hi[3]; // bounding box, inclusive
+    int where;        // WH_INTERIOR, WH_BOUNDARY and/or WH_GHOSTS
+  };
+
+  // Which of lower exterior (0), interior (1) and upper exterior (2)
+  // index x of an axis with n points and g ghosts lies in.
+  int region_of(int x,int g,int n);
+
+  // The region (WH_INTERIOR, WH_BOUNDARY and/or WH_GHOSTS) of the
+  // changed blocks, by block_index()
+  int classify_blocks(const cGH *cctkGH,const bool changed[27]);
+
+  // Returns false if nothing changed
+  bool diff_regions(const cGH *cctkGH,const region_cksum_t& before,
+                    const region_cksum_t& after,write_extent& ext);
+
+  // One grid function to checksum in a batch. If regions is set, the
+  // region checksum is filled in as well.
+  struct cksum_job {
+    const unsigned long *ldata;
+    cksum_t cksum;
+    region_cksum_t *regions;
+  };
+
+  // Checksum all jobs, in parallel over k-planes and batches of jobs.
+  // nthreads <= 0 means use the OpenMP default.
+  void compute_cksums(const cGH *cctkGH,std::vector<cksum_job>& jobs,int nthreads);
+}
+
+#endif
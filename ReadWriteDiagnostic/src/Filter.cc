@@ -0,0 +1,80 @@
+#include <fnmatch.h>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cctk.h>
+#include <cctk_Parameters.h>
+
+#include "Filter.hh"
+#include "Log.hh"
+
+namespace Read_Write_Diagnostics {
+
+  bool filter_active = false;
+
+  namespace {
+    typedef std::vector<std::string> pattern_list;
+    pattern_list thorns, routines, bins, skips;
+
+    // Decisions so far, by schedule item
+    std::unordered_map<const cFunctionData *,bool> skipped;
+
+    void compile(const char *list,pattern_list& patterns) {
+      std::istringstream in(list);
+      std::string p;
+      while(in >> p)
+        patterns.push_back(p);
+      if(!patterns.empty())
+        filter_active = true;
+    }
+
+    bool matches(const pattern_list& patterns,const std::string& name) {
+      for(auto p=patterns.begin();p != patterns.end();++p)
+        if(fnmatch(p->c_str(),name.c_str(),FNM_CASEFOLD) == 0)
+          return true;
+      return false;
+    }
+
+    // Routine patterns may name the routine alone or thorn::routine
+    bool decide(const cFunctionData *attribute) {
+      const std::string thorn = attribute->thorn;
+      const std::string routine = attribute->routine;
+      const std::string full = thorn + "::" + routine;
+      const std::string where = attribute->where != 0 ? attribute->where : "";
+      if(!thorns.empty() && !matches(thorns,thorn))
+        return true;
+      if(!routines.empty() && !matches(routines,routine) && !matches(routines,full))
+        return true;
+      if(!bins.empty() && !matches(bins,where))
+        return true;
+      return matches(skips,routine) || matches(skips,full);
+    }
+  }
+
+  void filter_compile() {
+    DECLARE_CCTK_PARAMETERS;
+    thorns.clear();
+    routines.clear();
+    bins.clear();
+    skips.clear();
+    skipped.clear();
+    filter_active = false;
+    compile(check_thorns,thorns);
+    compile(check_routines,routines);
+    compile(check_bins,bins);
+    compile(skip_routines,skips);
+  }
+
+  bool filter_skips(const cFunctionData *attribute) {
+    auto f = skipped.find(attribute);
+    if(f != skipped.end())
+      return f->second;
+    const bool skip = decide(attribute);
+    if(skip) {
+      RDWR_LOG(LOG_INFO) << "RDWR: Not checking " << attribute->thorn << "::" << attribute->routine;
+    }
+    skipped[attribute] = skip;
+    return skip;
+  }
+}
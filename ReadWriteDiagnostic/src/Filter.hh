@@ -0,0 +1,24 @@
+#ifndef RDWR_FILTER_HH
+#define RDWR_FILTER_HH
+
+#include <cctk_Schedule.h>
+
+namespace Read_Write_Diagnostics {
+
+  // Selection of the routines to check, by shell-style patterns (see
+  // fnmatch(3), case insensitive) on the thorn, the routine and the
+  // schedule bin. A routine is checked if it matches every non-empty
+  // check_* list and no pattern of skip_routines. The decision is made
+  // once per schedule item; skipped routines then cost the hooks one
+  // lookup.
+
+  // Compile the pattern lists. Sets filter_active if there are any.
+  void filter_compile();
+
+  extern bool filter_active;
+
+  // Whether the hooks should leave a routine alone
+  bool filter_skips(const cFunctionData *attribute);
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cctk.h>
+#include <cctk_Parameters.h>
+
+#include "Log.hh"
+
+namespace Read_Write_Diagnostics {
+
+  namespace {
+    // A bounded multi-producer queue after D. Vyukov: slot n is free for
+    // ticket t when its seq == t, and holds the message of ticket t when
+    // seq == t+1. Longer messages are truncated.
+    const int nslots = 4096;
+    const int text_bytes = 500;
+    struct slot {
+      std::atomic<uint64_t> seq;
+      float time;
+      short level;
+      short len;
+      char text[text_bytes];
+    };
+    std::vector<slot> ring(nslots);
+    std::atomic<uint64_t> head(0);
+    uint64_t tail = 0;
+    std::atomic<long> dropped(0);
+
+    enum { NOT_STARTED, RUNNING, STOPPED };
+    std::atomic<int> state(NOT_STARTED);
+    std::atomic<bool> stop(false);
+    std::mutex state_mutex;
+    std::thread drainer;
+
+    FILE *sink = 0;
+    bool binary = false;
+    std::chrono::steady_clock::time_point t0;
+
+    float now() {
+      using namespace std::chrono;
+      return duration<float>(steady_clock::now() - t0).count();
+    }
+
+    void open_sink() {
+      DECLARE_CCTK_PARAMETERS;
+      binary = CCTK_Equals(log_sink,"binary");
+      if(CCTK_Equals(log_sink,"stdout")) {
+        sink = stdout;
+        return;
+      }
+      char name[1024];
+      snprintf(name,sizeof(name),"%s.%d.%s",log_file,CCTK_MyProc(NULL),binary ? "bin" : "txt");
+      sink = fopen(name,binary ? "wb" : "w");
+      if(sink == 0) {
+        fprintf(stderr,"RDWR: cannot open %s, logging to stdout\n",name);
+        sink = stdout;
+        binary = false;
+      } else if(binary) {
+        fwrite("RDWRLOG1",1,8,sink);
+      }
+    }
+
+    // Binary records: float time, int16 level, int16 length, text
+    void write_one(float time,int level,const char *text,int len) {
+      if(binary) {
+        const int16_t lv = level, ln = len;
+        fwrite(&time,sizeof(time),1,sink);
+        fwrite(&lv,sizeof(lv),1,sink);
+        fwrite(&ln,sizeof(ln),1,sink);
+        fwrite(text,1,len,sink);
+      } else if(sink == stdout) {
+        fwrite(text,1,len,sink);
+        fputc('\n',sink);
+      } else {
+        fprintf(sink,"%.6f %c %.*s\n",time,"EWIT"[level],len,text);
+      }
+    }
+
+    // Write out the queued messages, returns how many there were
+    int drain() {
+      int n = 0;
+      for(;;) {
+        slot& s = ring[tail % nslots];
+        if(s.seq.load(std::memory_order_acquire) != tail+1)
+          break;
+        write_one(s.time,s.level,s.text,s.len);
+        s.seq.store(tail+nslots,std::memory_order_release);
+        tail++;
+        n++;
+      }
+      if(n > 0)
+        fflush(sink);
+      return n;
+    }
+
+    void drain_loop() {
+      while(!stop.load(std::memory_order_acquire)) {
+        if(drain() == 0)
+          std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+      drain();
+    }
+
+    void start() {
+      std::lock_guard<std::mutex> lock(state_mutex);
+      if(state.load() != NOT_STARTED)
+        return;
+      t0 = std::chrono::steady_clock::now();
+      for(int n=0;n<nslots;n++)
+        ring[n].seq.store(n,std::memory_order_relaxed);
+      open_sink();
+      drainer = std::thread(drain_loop);
+      std::atexit(log_flush);
+      state.store(RUNNING,std::memory_order_release);
+    }
+  }
+
+  bool log_enabled(int level) {
+    DECLARE_CCTK_PARAMETERS;
+    return level <= verbosity;
+  }
+
+  void log_message(int level,const std::string& msg) {
+    if(state.load(std::memory_order_acquire) != RUNNING) {
+      start();
+      if(state.load() == STOPPED) {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        write_one(now(),level,msg.data(),msg.size());
+        fflush(sink);
+        return;
+      }
+    }
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    slot *s;
+    for(;;) {
+      s = &ring[pos % nslots];
+      const int64_t dif = int64_t(s->seq.load(std::memory_order_acquire) - pos);
+      if(dif == 0) {
+        if(head.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))
+          break;
+      } else if(dif < 0) {
+        // Full: drop rather than wait for the sink
+        dropped++;
+        return;
+      } else {
+        pos = head.load(std::memory_order_relaxed);
+      }
+    }
+    s->time = now();
+    s->level = level;
+    s->len = std::min(int(msg.size()),text_bytes);
+    memcpy(s->text,msg.data(),s->len);
+    s->seq.store(pos+1,std::memory_order_release);
+  }
+
+  void log_flush() {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    if(state.load() != RUNNING)
+      return;
+    stop.store(true,std::memory_order_release);
+    drainer.join();
+    if(dropped > 0) {
+      char msg[100];
+      const int len = snprintf(msg,sizeof(msg),"RDWR: %ld messages dropped, the log buffer was full",dropped.load());
+      write_one(now(),LOG_WARNING,msg,len);
+    }
+    fflush(sink);
+    state.store(STOPPED,std::memory_order_release);
+  }
+}
@@ -0,0 +1,40 @@
+#ifndef RDWR_LOG_HH
+#define RDWR_LOG_HH
+
+#include <sstream>
+#include <string>
+
+namespace Read_Write_Diagnostics {
+
+  // All output of the thorn goes through a per-process ring buffer that
+  // a background thread drains into the sink selected by log_sink, so
+  // the hooks never wait for terminal or file I/O. Messages above the
+  // verbosity parameter are not formatted at all.
+  enum log_level { LOG_ERROR, LOG_WARNING, LOG_INFO, LOG_TRACE };
+
+  bool log_enabled(int level);
+
+  // Queue one message (one line, without the newline)
+  void log_message(int level,const std::string& msg);
+
+  // Write out everything queued so far and stop the background thread.
+  // Later messages are written synchronously.
+  void log_flush();
+
+  // Formats one message, queued at the end of the statement:
+  //   RDWR_LOG(LOG_INFO) << "x=" << x;
+  struct log_line {
+    int level;
+    std::ostringstream os;
+    explicit log_line(int level_) : level(level_) {}
+    ~log_line() { log_message(level,os.str()); }
+    template<typename T>
+    log_line& operator<<(const T& t) { os << t; return *this; }
+  };
+}
+
+#define RDWR_LOG(level) \
+  if(!Read_Write_Diagnostics::log_enabled(level)) ; \
+  else Read_Write_Diagnostics::log_line(level)
+
+#endif
@@ -4,22 +4,35 @@
 #include <iostream>
 #include <cstring>
 #include <string>
+#include <tuple>
+#include <algorithm>
+#include <unordered_map>
 #include <ScheduleWrapper.hh>
+#include "Checksum.hh"
+#include "SoftDirty.hh"
+#include "Shadow.hh"
+#include "Trap.hh"
+#include "Watch.hh"
+#include "Sampling.hh"
+#include "Log.hh"
+#include "Report.hh"
+#include "Record.hh"
+#include "Filter.hh"
 #include <cctk_Sync.h>
 #include <cctk_Arguments.h>
 #include <cctk_Parameters.h>
 #include <cctk_Functions.h>
 #include <sstream>
 #include <stdlib.h>
+#include <stdint.h>
 
 #include "PreSync.h"
+#include "public_rdwr_declare.h"
 
 extern "C" void CCTK_Checked_called(), CCTK_Checked_reset();
 extern "C" int CCTK_Checked_get();
 
 namespace Read_Write_Diagnostics {
-  static unsigned short internet_checksum(void const *restrict const addr,
-                                          size_t const len);
   struct VarName {
     char *name;
     VarName(int vi) : name(CCTK_FullName(vi)) {}
@@ -39,73 +52,6 @@ namespace Read_Write_Diagnostics {
 #define WH_NOWHERE             0x0
 #define WH_EXTERIOR            0x3
 #endif
-  void traceVars(const cGH *cctkGH) {;
-    const char *ixs = getenv("RDWR_DEBUG_INDEXES");
-    int xv=0,yv=0,zv=0;
-    if(ixs != 0) {
-      std::istringstream cns{ixs};
-      cns >> xv >> yv >> zv;
-    }
-
-    const char *dbv = getenv("RDWR_DEBUG_VARS");
-    if(dbv == 0)
-      return;
-  
-    std::istringstream ins{dbv};
-    while(ins.good()) {
-      std::string vname;
-      ins >> vname;
-      //const char *vname = "ADMBASE::gxx";
-      int tl = 0;
-      while(vname.rfind("_p") == vname.size()-2) {
-        tl += 1;
-        vname = vname.erase(vname.size()-2);
-      }
-      int vi_ = CCTK_VarIndex(vname.c_str());
-      if(vi_ < 0 ) {
-        CCTK_VERROR("Unknown variable name: %s", vname.c_str());
-      }
-      assert(vi_ >= 0);
-      int cc = CCTK_GFINDEX3D(cctkGH,xv,yv,zv);
-      CCTK_REAL *ptr = (CCTK_REAL*)CCTK_VarDataPtrI(cctkGH,tl,vi_);
-      int wh = Carpet_GetValidRegion(vi_,tl);
-      std::string whs;
-      if((wh & WH_INTERIOR) != 0) whs += "I";
-      if((wh & WH_BOUNDARY) != 0) whs += "B";
-      if((wh & WH_GHOSTS) != 0) whs += "G";
-      // add the _p's back
-      for(int i = 0 ; i < tl ; ++i)
-        vname += "_p";
-      if(ptr == 0)
-        std::cout << " RDWR:  " << vname << " := ??? (" << whs << ")" << std::endl;
-      else {
-        if(xv == -1 && yv == -1 && zv == -1) {
-          unsigned int cksum = internet_checksum(ptr, cctkGH->cctk_ash[0]*cctkGH->cctk_ash[1]*cctkGH->cctk_ash[2]*sizeof(CCTK_REAL));
-          std::cout << " RDWR:  " << vname << " := " << cksum << " (" << whs << ")" << std::endl;
-        } else {
-          std::cout << " RDWR:  " << vname << " := " << ptr[cc] << " (" << whs << ")" << std::endl;
-        }
-      }
-    }
-  }
-
-  struct cksum_t {
-    unsigned long in, out;
-    cksum_t() : in(0), out(0) {}
-  };
-
-  std::map<int,cksum_t> cksums;
-  std::set<std::string> messages;
-
-  inline bool operator==(const cksum_t& c1,const cksum_t& c2) {
-    return c1.in == c2.in && c1.out == c2.out;
-  }
-  inline bool operator!=(const cksum_t& c1,const cksum_t& c2) {
-    return c1.in != c2.in || c1.out != c2.out;
-  }
-  inline std::ostream& operator<<(std::ostream& out,const cksum_t& c) {
-    return out << std::hex << c.in << ":" << c.out << std::dec;
-  }
   inline const char *wh_name(int n) {
     if(n == WH_EVERYWHERE) 
       return "everywhere";
@@ -125,6 +71,65 @@ namespace Read_Write_Diagnostics {
       return "interior+ghosts";
     return "?";
   }
+
+  // Describe where a write took place relative to the interior,
+  // e.g. "interior minus 1 layer" or "upper-z boundary".
+  std::string describe_extent(const cGH *cctkGH,const write_extent& ext) {
+    const int *cctk_nghostzones = cctkGH->cctk_nghostzones;
+    const int *cctk_lsh = cctkGH->cctk_lsh;
+    const char *axis = "xyz";
+    std::ostringstream desc;
+    // Distance of each face of the box from the interior's face,
+    // negative if the box extends into the exterior.
+    int inset[6];
+    bool uniform = true;
+    for(int d=0;d<3;d++) {
+      inset[2*d] = ext.lo[d]-cctk_nghostzones[d];
+      inset[2*d+1] = (cctk_lsh[d]-cctk_nghostzones[d]-1)-ext.hi[d];
+    }
+    for(int f=1;f<6;f++)
+      uniform = uniform && inset[f] == inset[0];
+    bool everywhere = true;
+    for(int d=0;d<3;d++)
+      everywhere = everywhere && ext.lo[d] == 0 && ext.hi[d] == cctk_lsh[d]-1;
+    // A face slab of the exterior that contains the whole box
+    int face = -1;
+    for(int d=0;d<3 && face < 0;d++) {
+      if(ext.hi[d] < cctk_nghostzones[d])
+        face = 2*d;
+      else if(ext.lo[d] >= cctk_lsh[d]-cctk_nghostzones[d])
+        face = 2*d+1;
+    }
+    if(everywhere) {
+      desc << "everywhere";
+    } else if(uniform && inset[0] == 0) {
+      desc << "interior";
+    } else if(uniform) {
+      const int n = inset[0] > 0 ? inset[0] : -inset[0];
+      desc << "interior " << (inset[0] > 0 ? "minus " : "plus ") << n
+           << (n == 1 ? " layer" : " layers");
+    } else if(face >= 0) {
+      desc << "only " << (face % 2 == 0 ? "lower-" : "upper-") << axis[face/2]
+           << (cctkGH->cctk_bbox[face] ? " boundary" : " ghosts");
+    } else {
+      desc << "box";
+    }
+    if(!everywhere && !(uniform && inset[0] >= 0)) {
+      desc << " i=[" << ext.lo[0] << "," << ext.hi[0] << "]"
+           << " j=[" << ext.lo[1] << "," << ext.hi[1] << "]"
+           << " k=[" << ext.lo[2] << "," << ext.hi[2] << "]";
+      const char *sep = ", touching ";
+      for(int f=0;f<6 && face < 0;f++) {
+        if(inset[f] < 0) {
+          desc << sep << (f % 2 == 0 ? "lower-" : "upper-") << axis[f/2]
+               << (cctkGH->cctk_bbox[f] ? " boundary" : " ghosts");
+          sep = ", ";
+        }
+      }
+    }
+    return desc.str();
+  }
+
   inline void tolower(std::string& s) {
     for(auto si=s.begin();si != s.end();++si) {
       if(*si >= 'A' && *si <= 'Z') {
@@ -142,11 +147,253 @@ namespace Read_Write_Diagnostics {
       else return false;
     }
   };
-  std::map<std::string,std::map<var_tuple,int> > wclauses, rclauses;
-  std::map<std::string,std::set<int> > syncs;
-  std::map<int,std::map<int,std::string> > track_syncs;
+  std::map<var_tuple,region_cksum_t> region_cksums;
+
+  // A clause of a routine: the region of a variable it reads or writes
+  struct clause_t {
+    var_tuple vt;
+    int where;
+    bool operator<(const clause_t& b) const { return vt < b.vt; }
+  };
+
+  // A write observed in a routine, and the last diagnostic it produced
+  struct observed_t {
+    var_tuple vt;
+    int where;
+    int reported;
+    int first_iteration;
+    bool operator<(const observed_t& b) const { return vt < b.vt; }
+  };
+
+  // Look up vt in a sorted vector of clauses or observed writes
+  template<typename T>
+  T *find_var(std::vector<T>& v,const var_tuple& vt) {
+    T key;
+    key.vt = vt;
+    auto f = std::lower_bound(v.begin(),v.end(),key);
+    if(f == v.end() || vt < f->vt)
+      return 0;
+    return &*f;
+  }
+
+  // Access rights of a routine per (vi,tl) slot, two bits per slot:
+  // RDWR_ACCESS_READ and RDWR_ACCESS_WRITE.
+  struct access_bits {
+    std::vector<uint64_t> words;
+    inline void set(int slot,int bits) {
+      words[slot >> 5] |= uint64_t(bits) << ((slot & 31)*2);
+    }
+  };
+  int num_vars = 0, num_tls = 0;
+
+  inline int access_slot(int vi,int tl) { return vi*num_tls+tl; }
+
+  // Access outside of any clauses. Variables that are not real grid
+  // functions are not checked, so they are always accessible.
+  access_bits no_access;
+
+  // Access of the routines the filters skip: everything
+  access_bits all_access;
+
+  // The access rights of the current routine
+  const uint64_t *current_access = 0;
+
+  // The variables that can be checked: real grid functions. Built once
+  // at startup; the active timelevels are filled in at CCTK_BASEGRID.
+  struct catalog_t {
+    std::vector<int> max_tls;      // vi -> timelevels, 0 if not checked
+    std::vector<int> active_tls;   // vi -> active timelevels
+    std::vector<var_tuple> tl0;    // checked variables on tl 0, sorted
+    std::vector<var_tuple> all;    // checked variables on all tls, sorted
+    inline bool checked(const var_tuple& vt) const {
+      return vt.tl < active_tls[vt.vi];
+    }
+  };
+  catalog_t catalog;
+
+  // Where a routine runs. The post-call checksums of a routine are only
+  // reused by the very next routine, and only in the same place, since
+  // anything that happens between other hooks (SYNCs, prolongation,
+  // timelevel cycling, regridding) is not seen by RDWR.
+  struct call_context {
+    int iteration, rl, map, component;
+    const char *where;
+    int lsh[3], lbnd[3];
+  };
+
+  inline bool operator==(const call_context& a,const call_context& b) {
+    return a.iteration == b.iteration && a.rl == b.rl && a.map == b.map &&
+      a.component == b.component && a.where == b.where &&
+      memcmp(a.lsh,b.lsh,sizeof(a.lsh)) == 0 && memcmp(a.lbnd,b.lbnd,sizeof(a.lbnd)) == 0;
+  }
+
+  // Whether a driver provides GetLocalComponent, see build_catalog()
+  bool has_component = false;
+
+  call_context current_context(const cGH *cctkGH,const cFunctionData *attribute) {
+    call_context c;
+    c.iteration = cctkGH->cctk_iteration;
+    c.rl = GetRefinementLevel(cctkGH);
+    c.map = GetMap(cctkGH);
+    c.component = has_component ? GetLocalComponent(cctkGH) : 0;
+    c.where = attribute->where;
+    for(int d=0;d<3;d++) {
+      c.lsh[d] = cctkGH->cctk_lsh[d];
+      c.lbnd[d] = cctkGH->cctk_lbnd[d];
+    }
+    return c;
+  }
+
+  // Counts every routine call. The checksums a routine leaves behind
+  // carry its generation, and the context it ran in.
+  uint64_t generation = 0;
+  uint64_t carried_generation = uint64_t(-1);
+  call_context context, carried_context;
+  long cksums_reused = 0, cksums_computed = 0;
+
+  // The last checksum of every (vi,tl), by access_slot(), for the
+  // (rl,map,component) and storage it was computed on
+  struct cksum_state {
+    cksum_t cksum;
+    const void *data;
+    uint64_t generation;
+  };
+  std::vector<cksum_state> cksums;
+
+  // Whether the checksum of (vi,tl) at data is the one left behind by
+  // the previous routine, in the same context
+  inline bool carried(int slot,const void *data) {
+    const cksum_state& c = cksums[slot];
+    return c.generation == carried_generation && carried_generation+1 == generation &&
+      c.data == data && carried_context == context;
+  }
+
+  // With write_detection = "shadow", the copies of the checked variables
+  // taken before the current routine, by access_slot(). 0 for variables
+  // that are checksummed instead.
+  std::vector<const CCTK_REAL *> shadow_copies;
+
+  void build_catalog() {
+    if(current_access != 0)
+      return;
+    has_component = CCTK_IsFunctionAliased("GetLocalComponent");
+    num_vars = CCTK_NumVars();
+    num_tls = 1;
+    catalog.max_tls.assign(num_vars,0);
+    for(int vi=0;vi<num_vars;vi++) {
+      int type = CCTK_GroupTypeFromVarI(vi);
+      if(type == CCTK_GF && CCTK_VarTypeSize(CCTK_VarTypeI(vi)) == sizeof(CCTK_REAL))
+        catalog.max_tls[vi] = std::max(1,CCTK_MaxTimeLevelsVI(vi));
+      num_tls = std::max(num_tls,CCTK_MaxTimeLevelsVI(vi));
+    }
+    catalog.active_tls = catalog.max_tls;
+    for(int vi=0;vi<num_vars;vi++) {
+      if(catalog.max_tls[vi] == 0)
+        continue;
+      catalog.tl0.push_back(var_tuple{vi,0});
+      for(int tl=0;tl<catalog.max_tls[vi];tl++)
+        catalog.all.push_back(var_tuple{vi,tl});
+    }
+    cksums.assign(num_vars*num_tls,cksum_state{cksum_t(),0,uint64_t(-1)});
+    shadow_copies.assign(num_vars*num_tls,0);
+
+    no_access.words.assign((num_vars*num_tls+31)/32,0);
+    for(int vi=0;vi<num_vars;vi++) {
+      if(catalog.max_tls[vi] > 0)
+        continue;
+      for(int tl=0;tl<num_tls;tl++)
+        no_access.set(access_slot(vi,tl),RDWR_ACCESS_READ|RDWR_ACCESS_WRITE);
+    }
+    all_access.words.assign(no_access.words.size(),~uint64_t(0));
+    current_access = no_access.words.data();
+  }
+
+  // What checking a routine has cost this process, see
+  // RDWR_QueryOverhead. wclause is part of post.
+  struct overhead_t {
+    long calls = 0, checks = 0;
+    double pre = 0, post = 0, wclause = 0;   // seconds
+    long varptr_calls = 0;
+    double varptr = 0;                       // seconds, estimated
+    double bytes = 0;                        // hashed or compared
+    long variables = 0, timelevels = 0;      // checked, over all calls
+    long cache_hits = 0;                     // reused checksums
+  };
 
-  std::string routine;
+  // Everything known about a scheduled routine. Routines are interned
+  // into dense ids the first time their cFunctionData is seen, so the
+  // hooks do not need to build or compare routine names.
+  struct routine_info {
+    std::string name;                 // thorn::routine
+    std::vector<clause_t> writes;     // sorted
+    std::vector<clause_t> reads;      // sorted
+    std::vector<int> syncs;           // variables synced after the routine
+    std::vector<var_tuple> check;     // real GFs to checksum, sorted
+    std::vector<observed_t> observed; // sorted
+    access_bits access;               // includes no_access
+    overhead_t cost;
+    std::vector<const cFunctionData *> items; // schedule items calling it
+  };
+  std::vector<routine_info> routines;
+  std::unordered_map<const cFunctionData *,int> routine_ids;
+  std::map<std::string,int> routine_names;
+
+  // The SYNC state of the variables on a refinement level, by
+  // access_slot(). A SYNC only covers timelevel 0.
+  struct sync_tracker {
+    // The id of the routine that wrote the interior without a SYNC
+    // since, or -1
+    std::vector<int> writer;
+    // The epoch in which the slot was last synced or written everywhere.
+    // Routines whose writes are unknown (without clauses, skipped by the
+    // filters, or in global mode) start a new epoch, so only slots that
+    // are clean in the current epoch are known to be synced.
+    std::vector<uint64_t> clean;
+    uint64_t epoch = 1;
+  };
+  std::vector<sync_tracker> track_syncs;
+
+  inline sync_tracker& track_syncs_rl(int rl) {
+    if(int(track_syncs.size()) <= rl)
+      track_syncs.resize(rl+1);
+    sync_tracker& track = track_syncs[rl];
+    if(track.writer.empty()) {
+      track.writer.assign(num_vars*num_tls,-1);
+      track.clean.assign(num_vars*num_tls,0);
+    }
+    return track;
+  }
+
+  // With elide_syncs or insert_syncs, the SYNC of a schedule item is
+  // rewritten before every call: groups whose variables are known to be
+  // synced are dropped, and groups that a reader found unsynced after
+  // the item are added. Carpet syncs after the post-call hook, so the
+  // post-call hook can still restore a group the routine was seen to
+  // write.
+  struct sync_plan {
+    std::vector<int> groups;   // as scheduled, plus inserted ones
+    std::vector<int> now;      // what the current call syncs
+    std::vector<int> elided;   // what it does not
+    bool fixed = false;        // MoL syncs by itself, leave it alone
+  };
+  std::unordered_map<const cFunctionData *,sync_plan> sync_plans;
+  bool plan_syncs = false;     // elide_syncs || insert_syncs
+  sync_plan *current_plan = 0;
+  std::vector<int> written_now; // interior writes seen in the current call
+
+  long syncs_elided = 0, syncs_inserted = 0;
+  double messages_avoided = 0, bytes_avoided = 0;
+
+  // The current routine
+  int rid = -1;
+
+  // Whether the current routine is checked at all, and whether it is
+  // checked with soft-dirty page tracking
+  bool sampled_call = true;
+  bool softdirty_call = false;
+
+  // Whether the current routine is skipped by the filters
+  bool skipped_call = false;
 
   void compute_clauses(const int num_strings,const char **strings,std::map<var_tuple,int>& routine_m) {
     for(int i=0;i< num_strings; ++i) {
@@ -157,7 +404,8 @@ namespace Read_Write_Diagnostics {
       const char *closep = strchr(clause,')');
       const char *end_impl = strchr(clause,':');
       if(end_impl == 0) {
-        std::cerr << "RDWR: bad str=" << strings[i] << std::endl;
+        RDWR_LOG(LOG_ERROR) << "RDWR: bad str=" << strings[i];
+        log_flush();
       }
       assert(end_impl != 0);
       std::string where, str;
@@ -180,7 +428,8 @@ namespace Read_Write_Diagnostics {
         } else if(where == "boundary") {
           where_val = WH_BOUNDARY;
         } else {
-          std::cout << "error in where clause for " << str << "=" << where << std::endl;
+          RDWR_LOG(LOG_ERROR) << "error in where clause for " << str << "=" << where;
+          log_flush();
           assert(false);
         }
       } else {
@@ -211,24 +460,17 @@ namespace Read_Write_Diagnostics {
             routine_m[vt] = where_val;
           }
         } else {
-          std::cerr << "RDWR: Could not find (" << str << ") using CCTK_VarIndex or CCTK_GroupIndex" << std::endl;
+          RDWR_LOG(LOG_WARNING) << "RDWR: Could not find (" << str << ") using CCTK_VarIndex or CCTK_GroupIndex";
         }
       }
     }
   }
 
-  void init_MoL() {
+  void init_MoL(const std::string& name,std::map<var_tuple,int>& writes_m) {
     // Special code for MoL
-    bool init = true;
-    if(!init) return;
-    std::string add = "MoL::MoL_Add";
-    std::map<var_tuple,int>& writes_add = wclauses[add];
-    std::string copy = "MoL::MoL_InitialCopy";
-    std::map<var_tuple,int>& writes_copy = wclauses[copy];
-    std::string rhs = "MoL::MoL_InitRHS";
-    std::map<var_tuple,int>& writes_rhs = wclauses[rhs];
-    if(routine != add && routine != copy && routine != rhs)
-      return;
+    const std::string add = "MoL::MoL_Add";
+    const std::string copy = "MoL::MoL_InitialCopy";
+    const std::string rhs = "MoL::MoL_InitRHS";
     int nv = CCTK_NumVars();
     for(int vi=0;vi<nv;vi++) {
       var_tuple vt{vi,0};
@@ -236,173 +478,708 @@ namespace Read_Write_Diagnostics {
       if(type == CCTK_GF && CCTK_VarTypeSize(CCTK_VarTypeI(vi)) == sizeof(CCTK_REAL)) {
         int rhsi = CCTK_IsFunctionAliased("MoLQueryEvolvedRHS") ? MoLQueryEvolvedRHS(vi) : -1;
         if(rhsi >= 0) {
-          writes_add[vt] = WH_INTERIOR;
-          writes_copy[vt] = WH_INTERIOR;
-          if(rhsi >= 0) {
+          if(name == add || name == copy) {
+            writes_m[vt] = WH_INTERIOR;
+          } else if(name == rhs) {
             var_tuple rhst{rhsi,0};
-            writes_rhs[rhst] = WH_INTERIOR;
+            writes_m[rhst] = WH_INTERIOR;
           }
-          init = false;
         }
       }
     }
   }
 
-  void init_function(const cFunctionData *attribute) {
-    if(wclauses.find(routine) != wclauses.end())
+  inline bool is_MoL(const std::string& name) {
+    return name == "MoL::MoL_Add" || name == "MoL::MoL_InitialCopy" || name == "MoL::MoL_InitRHS";
+  }
+
+  void init_function(const cFunctionData *attribute,routine_info& info) {
+    std::map<var_tuple,int> writes_m, reads_m;
+    std::set<int> syncs_s;
+    if(is_MoL(info.name)) {
+      // MoL's clauses are computed from the evolved variables
+      init_MoL(info.name,writes_m);
+    } else {
+      compute_clauses(
+        attribute->n_WritesClauses,
+        attribute->WritesClauses,
+        writes_m);
+      compute_clauses(
+        attribute->n_ReadsClauses,
+        attribute->ReadsClauses,
+        reads_m);
+
+      for(int i=0;i<attribute->n_SyncGroups;i++) {
+        int gi = attribute->SyncGroups[i];
+        int i0 = CCTK_FirstVarIndexI(gi);
+        int iN = i0+CCTK_NumVarsInGroupI(gi);
+        for(int vi=i0;vi<iN;vi++) {
+          syncs_s.insert(vi);
+        }
+      }
+    }
+
+    DECLARE_CCTK_PARAMETERS;
+    std::set<var_tuple> check;
+    for(auto i=writes_m.begin();i != writes_m.end();++i) {
+      info.writes.push_back(clause_t{i->first,i->second});
+      check.insert(i->first);
+    }
+    for(auto i=reads_m.begin();i != reads_m.end();++i) {
+      info.reads.push_back(clause_t{i->first,i->second});
+      check.insert(i->first);
+    }
+    for(auto i=writes_m.begin();i != writes_m.end();++i) {
+      int vi = i->first.vi;
+      if(catalog.max_tls[vi] == 0) {
+        check.erase(i->first);
+      } else if(check_all_timelevels) {
+        for(int tl=0;tl<catalog.max_tls[vi];tl++)
+          check.insert(var_tuple{vi,tl});
+      }
+    }
+    for(auto i=reads_m.begin();i != reads_m.end();++i) {
+      int vi = i->first.vi;
+      if(catalog.max_tls[vi] == 0) {
+        check.erase(i->first);
+      } else if(check_all_timelevels) {
+        for(int tl=0;tl<catalog.max_tls[vi];tl++)
+          check.insert(var_tuple{vi,tl});
+      }
+    }
+    info.syncs.assign(syncs_s.begin(),syncs_s.end());
+    info.check.assign(check.begin(),check.end());
+
+    info.access = no_access;
+    for(auto i=info.writes.begin();i != info.writes.end();++i) {
+      if(i->vt.tl < num_tls)
+        info.access.set(access_slot(i->vt.vi,i->vt.tl),RDWR_ACCESS_WRITE);
+    }
+    for(auto i=info.reads.begin();i != info.reads.end();++i) {
+      if(i->vt.tl < num_tls)
+        info.access.set(access_slot(i->vt.vi,i->vt.tl),RDWR_ACCESS_READ);
+    }
+  }
+
+  // Map attribute to its routine id, creating it on first sight
+  int intern_routine(const cFunctionData *attribute) {
+    auto f = routine_ids.find(attribute);
+    if(f != routine_ids.end())
+      return f->second;
+
+    build_catalog();
+
+    // A routine scheduled more than once keeps the clauses
+    // of the first schedule item seen.
+    std::string name = attribute->thorn;
+    name += "::";
+    name += attribute->routine;
+    auto n = routine_names.find(name);
+    int id;
+    if(n != routine_names.end()) {
+      id = n->second;
+    } else {
+      id = routines.size();
+      routines.push_back(routine_info());
+      routines[id].name = name;
+      init_function(attribute,routines[id]);
+      routine_names[name] = id;
+    }
+    routine_ids[attribute] = id;
+    routines[id].items.push_back(attribute);
+    return id;
+  }
+
+  // The variables to checksum for the current routine
+  inline const std::vector<var_tuple>& variables_to_check() {
+    DECLARE_CCTK_PARAMETERS;
+    const routine_info& info = routines[rid];
+    if(!info.check.empty())
+      return info.check;
+    // No read-write clauses. Check everything.
+    if(info.writes.empty() && info.reads.empty())
+      return check_all_timelevels ? catalog.all : catalog.tl0;
+    return info.check;
+  }
+
+  // Past timelevels as written in clauses: rho_p_p is rho on tl 2
+  std::string tl_suffix(int tl) {
+    std::string s;
+    for(int i=0;i<tl;i++)
+      s += "_p";
+    return s;
+  }
+
+  std::string format_finding(const finding& f,const std::string& routine,const std::string& other) {
+    std::ostringstream msg;
+    VarName vn(f.vi);
+    switch(f.kind) {
+    case FOUND_MISSING_WRITES:
+      msg << "error: Routine " << routine << "() is missing WRITES: "
+        << vn << tl_suffix(f.tl) << "(" << wh_name(f.where) << ") ";
+      break;
+    case FOUND_MISSING_READS:
+      msg << "error: Routine " << routine << "() is missing READS: " << vn << tl_suffix(f.tl) << " ";
+      break;
+    case FOUND_WRONG_REGION:
+      msg << "RDWR error: Routine " << routine << "() has "
+        << "incorrect region for region of "
+        << "writes clause for " << vn << tl_suffix(f.tl) << ": "
+        << " schedule=" << wh_name(f.declared)
+        << " observed=" << wh_name(f.where);
+      break;
+    case FOUND_NEEDS_SYNC:
+      msg << "error: in routine " << routine << ". Variable " << vn <<
+        " (group " << CCTK_GroupNameFromVarI(f.vi) << " tl=" << f.tl << ") needs to be synced by " << other;
+      break;
+    case FOUND_NEEDLESS_SYNC:
+      msg << "warning: Variable " << vn <<
+        " (group " << CCTK_GroupNameFromVarI(f.vi) << ") does not need to be synced by " << routine;
+      break;
+    case FOUND_WRITE_EXTENT:
+      msg << "note: Routine " << routine << "() writes " << vn << " (tl=" << f.tl << ") in ("
+        << wh_name(f.where) << ") within i=[" << f.lo[0] << "," << f.hi[0] << "] j=["
+        << f.lo[1] << "," << f.hi[1] << "] k=[" << f.lo[2] << "," << f.hi[2] << "] on rl " << f.rl;
+      break;
+    case FOUND_OBSERVED_WRITE:
+      msg << "note: Routine " << routine << "() writes " << vn << tl_suffix(f.tl) << "(" << wh_name(f.where) << ")";
+      break;
+    case FOUND_DECLARED_WRITE:
+      msg << "note: Routine " << routine << "() declares WRITES: " << vn << tl_suffix(f.tl) << "(" << wh_name(f.where) << ")";
+      break;
+    case FOUND_DECLARED_READ:
+      msg << "note: Routine " << routine << "() declares READS: " << vn << tl_suffix(f.tl) << "(" << wh_name(f.where) << ")";
+      break;
+    }
+    return msg.str();
+  }
+
+  // Record a finding of the current routine, and log it when it is new
+  void report(const cGH *cctkGH,finding f,const std::string& other = "") {
+    const std::string& routine = routines[rid].name;
+    f.first_iteration = cctkGH->cctk_iteration;
+    if(!add_finding(f,routine,other))
       return;
+    const int level = f.kind == FOUND_NEEDLESS_SYNC ? LOG_WARNING :
+      f.kind == FOUND_WRITE_EXTENT ? LOG_INFO : LOG_ERROR;
+    RDWR_LOG(level) << format_finding(f,routine,other);
+  }
 
-    std::map<var_tuple,int>& writes_m = wclauses[routine];
-    compute_clauses(
-      attribute->n_WritesClauses,
-      attribute->WritesClauses,
-      writes_m);
-    std::map<var_tuple,int>& reads_m = rclauses[routine];
-    compute_clauses(
-      attribute->n_ReadsClauses,
-      attribute->ReadsClauses,
-      reads_m);
-
-    std::set<int>& syncs_s = syncs[routine];
-    for(int i=0;i<attribute->n_SyncGroups;i++) {
-      int gi = attribute->SyncGroups[i];
-      int i0 = CCTK_FirstVarIndexI(gi);
-      int iN = i0+CCTK_NumVarsInGroupI(gi);
-      for(int vi=i0;vi<iN;vi++) {
-        syncs_s.insert(vi);
-      }
-    }
-  }
-
-  // routine -> var_index -> where_val
-  std::map<std::string,std::map<var_tuple,int> > observed_writes;
-  // Compare observed writes to what is specified in schedule.ccl
-  void wclause_diagnostic() {
-    for(auto it=observed_writes.begin();it != observed_writes.end(); ++it) {
-      const std::string& routine = it->first;
-      for(auto v=it->second.begin();v != it->second.end();++v) {
-        var_tuple vt = v->first;
-        //std::string imp = CCTK_ImpFromVarI(vt.vi);
-        auto wfind = wclauses.find(routine);
-        std::ostringstream msg;
-        if(wfind == wclauses.end()) {
-          msg << "error: " << routine << "() has no write clauses";
-        } else {
-          auto vfind = wfind->second.find(vt);
-          VarName vn(vt.vi);
-          if(vfind == wfind->second.end()) {
-            int where = Carpet_GetValidRegion(vt.vi,vt.tl);
-            int missing = v->second & ~where;
-            missing &= ~WH_GHOSTS;
-            if(missing != 0) {
-              msg << "error: Routine " << routine << "() is missing WRITES: "
-                << vn << "(" << wh_name(missing) << ") ";
-            }
-            /*
-            msg << "id=" << vt.vi << " ";
-            msg << "has=(";
-            for(auto m=wfind->second.begin();m != wfind->second.end();++m) {
-              msg << m->first << " ";
-            }
-            msg << ")";
-            */
-          } else if(v->second != vfind->second) {
-            msg << "RDWR error: Routine " << routine << "() has "
-              << "incorrect region for region of "
-              << "writes clause for " << vn << ": " 
-              << " schedule=" << wh_name(vfind->second)
-              << " observed=" << wh_name(v->second);
+  inline finding make_finding(int kind,const var_tuple& vt,int where) {
+    finding f = finding();
+    f.kind = kind;
+    f.vi = vt.vi;
+    f.tl = vt.tl;
+    f.where = where;
+    return f;
+  }
+
+  // Report the extent of a write found by comparing region checksums or
+  // shadow copies, which also count the written points. The log gets the
+  // extent of this call, the report the bounding box of all of them in
+  // global indices.
+  void extent_diagnostic(const cGH *cctkGH,const var_tuple& vt,const write_extent& ext,long npoints=-1) {
+    finding f = make_finding(FOUND_WRITE_EXTENT,vt,ext.where);
+    f.rl = GetRefinementLevel(cctkGH);
+    for(int d=0;d<3;d++) {
+      f.lo[d] = ext.lo[d] + cctkGH->cctk_lbnd[d];
+      f.hi[d] = ext.hi[d] + cctkGH->cctk_lbnd[d];
+    }
+    f.first_iteration = cctkGH->cctk_iteration;
+    if(!add_finding(f,routines[rid].name,""))
+      return;
+    RDWR_LOG(LOG_INFO) << "note: Routine " << routines[rid].name << "() writes " << VarName(vt.vi)
+      << " (tl=" << vt.tl << ") in " << describe_extent(cctkGH,ext) << " (" << wh_name(ext.where) << ")";
+    if(npoints >= 0) {
+      RDWR_LOG(LOG_INFO) << "note: " << npoints << " points of " << VarName(vt.vi) << " (tl=" << vt.tl << ") changed";
+    }
+  }
+
+  // Compare the observed writes of the current routine to what is
+  // specified in schedule.ccl. A diagnostic is only formatted when it
+  // differs from the last one reported for the same variable.
+  void wclause_diagnostic(const cGH *cctkGH) {
+    routine_info& info = routines[rid];
+    for(auto v=info.observed.begin();v != info.observed.end();++v) {
+      var_tuple vt = v->vt;
+      const clause_t *vfind = find_var(info.writes,vt);
+      int code = 0;
+      if(vfind == 0) {
+        int where = Carpet_GetValidRegion(vt.vi,vt.tl);
+        int missing = v->where & ~where;
+        missing &= ~WH_GHOSTS;
+        code = missing;
+      } else if(v->where != vfind->where) {
+        code = 0x10 | v->where;
+      }
+      if(code == 0 || code == v->reported)
+        continue;
+      v->reported = code;
+      if(vfind == 0) {
+        report(cctkGH,make_finding(FOUND_MISSING_WRITES,vt,code));
+      } else {
+        finding f = make_finding(FOUND_WRONG_REGION,vt,v->where);
+        f.declared = vfind->where;
+        report(cctkGH,f);
+      }
+    }
+  }
+
+  // Record an observed write, returns whether it is new
+  bool add_observed_write(const cGH *cctkGH,const var_tuple& vt,int where) {
+    if(recording())
+      record_write(vt.vi,vt.tl,where);
+    if(current_plan != 0 && vt.tl == 0 && (where & WH_INTERIOR) != 0)
+      written_now.push_back(vt.vi);
+    std::vector<observed_t>& observed = routines[rid].observed;
+    observed_t *o = find_var(observed,vt);
+    if(o == 0) {
+      observed_t ob{vt,where,0,cctkGH->cctk_iteration};
+      observed.insert(std::upper_bound(observed.begin(),observed.end(),ob),ob);
+      return true;
+    }
+    const bool new_write = (o->where | where) != o->where;
+    o->where |= where;
+    return new_write;
+  }
+
+  // The variables synced after the current call, sorted. With a plan,
+  // these are its groups, counting the elided ones, which finish_plan()
+  // may sync after all.
+  const std::vector<int>& synced_vars() {
+    if(current_plan == 0)
+      return routines[rid].syncs;
+    static std::vector<int> vars;
+    vars.clear();
+    for(int k=0;k<2;k++) {
+      const std::vector<int>& groups = k == 0 ? current_plan->now : current_plan->elided;
+      for(auto g=groups.begin();g != groups.end();++g) {
+        const int i0 = CCTK_FirstVarIndexI(*g);
+        for(int vi=i0;vi<i0+CCTK_NumVarsInGroupI(*g);vi++)
+          vars.push_back(vi);
+      }
+    }
+    std::sort(vars.begin(),vars.end());
+    return vars;
+  }
+
+  // Find the writes of the routine that just ran. Returns whether
+  // any of them was not observed before.
+  bool observe_writes(const cGH *cctkGH) {
+    DECLARE_CCTK_PARAMETERS;
+    bool new_writes = false;
+    const std::vector<var_tuple>& variables_to_check = Read_Write_Diagnostics::variables_to_check();
+    overhead_t& cost = routines[rid].cost;
+    const double gf_bytes = double(sizeof(CCTK_REAL))*cctkGH->cctk_ash[0]*cctkGH->cctk_ash[1]*cctkGH->cctk_ash[2];
+    cost.checks++;
+    // Kept across calls to avoid reallocating them
+    static std::vector<cksum_job> jobs;
+    static std::vector<var_tuple> job_vars;
+    jobs.clear();
+    job_vars.clear();
+    const std::vector<int>& syncs = synced_vars();
+    for(auto i = variables_to_check.begin();i != variables_to_check.end();++i) {
+      if(!catalog.checked(*i)) continue;
+      void *data = CCTK_VarDataPtrI(cctkGH,i->tl,i->vi);
+      if(data == 0) continue;
+      cost.variables++;
+      if(i->tl > 0)
+        cost.timelevels++;
+      if(softdirty_call) {
+        // Only variables on written pages that mix interior and exterior
+        // points are checksummed again
+        const int where = softdirty_written(cctkGH,data);
+        if(where < 0) {
+          static bool warned = false;
+          if(!warned) {
+            RDWR_LOG(LOG_WARNING) << "RDWR: cannot read the soft-dirty page map, using checksums";
+            warned = true;
           }
-          std::string smsg = msg.str();
-          if(smsg.size() > 0) {
-            if(messages.find(smsg) == messages.end()) {
-              messages.insert(smsg);
-              std::cout << smsg << std::endl;
-            }
+        } else if((where & SOFTDIRTY_MIXED) == 0) {
+          if(where > 0) {
+            new_writes |= add_observed_write(cctkGH,*i,where);
+          } else if(reuse_cksums && !std::binary_search(syncs.begin(),syncs.end(),i->vi)) {
+            // Unchanged, so the checksum from before still holds
+            cksum_state& state = cksums[access_slot(i->vi,i->tl)];
+            if(state.data == data)
+              state.generation = generation;
           }
+          continue;
+        }
+      }
+      const CCTK_REAL *&copy = shadow_copies[access_slot(i->vi,i->tl)];
+      if(copy != 0) {
+        cost.bytes += gf_bytes;
+        shadow_diff diff;
+        if(shadow_compare(cctkGH,copy,(const CCTK_REAL *)data,cksum_threads,diff)) {
+          int where = diff.count[block_index(1,1,1)] > 0 ? WH_INTERIOR : 0;
+          if(diff.total > diff.count[block_index(1,1,1)])
+            where |= WH_EXTERIOR;
+          new_writes |= add_observed_write(cctkGH,*i,where);
+          if(localize_writes)
+            extent_diagnostic(cctkGH,*i,diff.ext,diff.total);
         }
+        copy = 0;
+        continue;
       }
+      jobs.push_back(cksum_job{(unsigned long*)data,cksum_t(),0});
+      job_vars.push_back(*i);
     }
+    static std::vector<region_cksum_t> regions;
+    if(localize_writes) {
+      regions.resize(jobs.size());
+      for(size_t n=0;n<jobs.size();n++)
+        jobs[n].regions = &regions[n];
+    }
+    compute_cksums(cctkGH,jobs,cksum_threads);
+    cost.bytes += jobs.size()*gf_bytes;
+    for(size_t n=0;n<jobs.size();n++) {
+       const cksum_t& c = jobs[n].cksum;
+       cksum_state& state = cksums[access_slot(job_vars[n].vi,job_vars[n].tl)];
+       const cksum_t cn = state.cksum;
+        if(cn != c) {
+          int where=0;
+          if(cn.out != c.out)
+            where |= WH_EXTERIOR;
+          if(cn.in != c.in)
+            where |= WH_INTERIOR;
+          new_writes |= add_observed_write(cctkGH,job_vars[n],where);
+          write_extent ext;
+          if(localize_writes && diff_regions(cctkGH,region_cksums[job_vars[n]],regions[n],ext))
+            extent_diagnostic(cctkGH,job_vars[n],ext);
+        }
+        // Leave the checksum for the next routine, unless the variable
+        // is synced after this one
+        if(reuse_cksums && !std::binary_search(syncs.begin(),syncs.end(),job_vars[n].vi)) {
+          state.cksum = c;
+          state.data = jobs[n].ldata;
+          state.generation = generation;
+          if(localize_writes)
+            std::swap(region_cksums[job_vars[n]],regions[n]);
+        }
+    }
+    if(reuse_cksums) {
+      carried_generation = generation;
+      carried_context = context;
+    }
+    return new_writes;
   }
 
-  cksum_t compute_cksum(const cGH *cctkGH,unsigned long *ldata,int vi) {
-    const int *cctk_nghostzones = cctkGH->cctk_nghostzones;
-    const int *cctk_lsh = cctkGH->cctk_lsh;
-    const int bytes = sizeof(unsigned long);
-    cksum_t c;
-    #if 0
-    // When is the data supposed to become valid?
-    if (CCTK_IsFunctionAliased("Accelerator_RequireValidData")) {
-      bool on_device = 0;
-      int rl = GetRefinementLevel(cctkGH);
-      int tl = 0;
-      Accelerator_RequireValidData(cctkGH, &vi, &rl, &tl, 1, on_device);
+  // Record the state of the variables the current routine is checked
+  // for: checksums, shadow copies, or cleared soft-dirty bits
+  void snapshot_variables(const cGH *cctkGH) {
+    DECLARE_CCTK_PARAMETERS;
+    const std::vector<var_tuple>& variables_to_check = Read_Write_Diagnostics::variables_to_check();
+
+    // A call that elides a SYNC must be checked, see plan_call()
+    sampled_call = sampling_should_check(rid,cctkGH) ||
+      (current_plan != 0 && !current_plan->elided.empty());
+    if(!sampled_call)
+      return;
+
+    // With soft-dirty tracking, the checksums below are only compared
+    // after the routine for variables the page map cannot classify, see
+    // observe_writes(). Clearing the bits is the last thing to happen
+    // before the routine runs.
+    if(CCTK_Equals(write_detection,"softdirty")) {
+      softdirty_call = softdirty_available();
+      static bool warned = false;
+      if(!softdirty_call && !warned) {
+        RDWR_LOG(LOG_WARNING) << "RDWR: soft-dirty page tracking is not available, using checksums";
+        warned = true;
+      }
     }
-    #endif
-    for(int k=0;k<cctk_lsh[2];k++) {
-      const bool inz = (cctk_nghostzones[2] <= k && k < cctk_lsh[2]-cctk_nghostzones[2]);
-      for(int j=0;j<cctk_lsh[1];j++) {
-        const bool iny = (cctk_nghostzones[1] <= j && j < cctk_lsh[1]-cctk_nghostzones[1]);
-        for(int i=0;i<cctk_lsh[0];i++) {
-          const bool inx = (cctk_nghostzones[0] <= i && i < cctk_lsh[0]-cctk_nghostzones[0]);
-          const int cc = CCTK_GFINDEX3D(cctkGH,i,j,k);
-          const int n = (cc % bytes);
-          const int m = bytes-n;
-          unsigned long lg = (ldata[cc] << (bytes*n))|(ldata[cc] >> (bytes*m));
-          if(inx && iny && inz)
-            c.in ^= lg;
-          else
-            c.out ^= lg;
+
+    // Exact detection copies every checked variable, as long as the
+    // copies fit in shadow_budget_mb. The others are checksummed.
+    const bool shadow = CCTK_Equals(write_detection,"shadow");
+    size_t npoints = 1;
+    for(int d=0;d<3;d++)
+      npoints *= cctkGH->cctk_ash[d];
+    if(shadow)
+      shadow_reset();
+    overhead_t& cost = routines[rid].cost;
+
+    // Kept across calls to avoid reallocating them
+    static std::vector<cksum_job> jobs;
+    static std::vector<var_tuple> job_vars;
+    jobs.clear();
+    job_vars.clear();
+    for(auto i = variables_to_check.begin();i != variables_to_check.end();++i) {
+      if(!catalog.checked(*i)) continue;
+      void *data = CCTK_VarDataPtrI(cctkGH,i->tl,i->vi);
+      // No copy of a variable without storage, or beyond the budget
+      shadow_copies[access_slot(i->vi,i->tl)] = 0;
+      if(data == 0) continue;
+      if(shadow) {
+        const CCTK_REAL *copy = shadow_snapshot((const CCTK_REAL *)data,npoints,size_t(shadow_budget_mb) << 20);
+        shadow_copies[access_slot(i->vi,i->tl)] = copy;
+        if(copy != 0) {
+          cost.bytes += npoints*sizeof(CCTK_REAL);
+          continue;
+        }
+        static bool warned = false;
+        if(!warned) {
+          RDWR_LOG(LOG_WARNING) << "RDWR: shadow copies exceed shadow_budget_mb, using checksums for the rest";
+          warned = true;
         }
       }
+      if(reuse_cksums && carried(access_slot(i->vi,i->tl),data)) {
+        cksums_reused++;
+        cost.cache_hits++;
+        continue;
+      }
+      region_cksum_t *regions = localize_writes ? &region_cksums[*i] : 0;
+      jobs.push_back(cksum_job{(unsigned long*)data,cksum_t(),regions});
+      job_vars.push_back(*i);
     }
-    return c;
+    compute_cksums(cctkGH,jobs,cksum_threads);
+    cksums_computed += jobs.size();
+    cost.bytes += double(jobs.size())*npoints*sizeof(CCTK_REAL);
+    for(size_t n=0;n<jobs.size();n++) {
+      cksum_state& state = cksums[access_slot(job_vars[n].vi,job_vars[n].tl)];
+      state.cksum = jobs[n].cksum;
+      state.data = jobs[n].ldata;
+    }
+    if(softdirty_call)
+      softdirty_call = softdirty_clear();
   }
 
-  static unsigned short internet_checksum(void const *restrict const addr,
-                                          size_t const len) {
-    unsigned long chk = 0;
-#pragma omp parallel for reduction(+ : chk)
-    for (ptrdiff_t i = 0; i < (ptrdiff_t)len; i += 2) {
-      unsigned long const lb = ((unsigned char const *)addr)[i];
-      unsigned long const ub = ((unsigned char const *)addr)[i + 1];
-      chk += lb + (ub << 8);
+  // Protect the variables the current routine has no clauses for.
+  // Routines without any clauses may access everything.
+  void arm_trap(const cGH *cctkGH) {
+    const routine_info& info = routines[rid];
+    if(info.writes.empty() && info.reads.empty())
+      return;
+    size_t bytes = sizeof(CCTK_REAL);
+    for(int d=0;d<3;d++)
+      bytes *= cctkGH->cctk_ash[d];
+    for(auto i = catalog.all.begin();i != catalog.all.end();++i) {
+      if(!catalog.checked(*i) || RDWR_VarAccessI(cctkGH,i->tl,i->vi) != 0) continue;
+      void *data = CCTK_VarDataPtrI(cctkGH,i->tl,i->vi);
+      if(data != 0)
+        trap_add(access_slot(i->vi,i->tl),data,bytes);
     }
-    if (len % 1) {
-      unsigned long const lb = ((unsigned char const *)addr)[len - 1];
-      chk += lb;
+    trap_arm();
+  }
+
+  sync_plan& plan_of(const cFunctionData *attribute,const std::string& routine) {
+    auto p = sync_plans.find(attribute);
+    if(p == sync_plans.end()) {
+      p = sync_plans.insert(std::make_pair(attribute,sync_plan())).first;
+      p->second.groups.assign(attribute->SyncGroups,attribute->SyncGroups+attribute->n_SyncGroups);
+      p->second.fixed = is_MoL(routine);
     }
-    while (chk >> 16) {
-      chk = (chk & 0xffffUL) + (chk >> 16);
+    return p->second;
+  }
+
+  inline void set_syncs(const cFunctionData *attribute,std::vector<int>& groups) {
+    cFunctionData *item = const_cast<cFunctionData *>(attribute);
+    item->SyncGroups = groups.data();
+    item->n_SyncGroups = groups.size();
+  }
+
+  // A routine whose writes are unknown ran, see sync_tracker
+  void forget_syncs() {
+    for(auto t=track_syncs.begin();t != track_syncs.end();++t)
+      t->epoch++;
+  }
+
+  // The variables each skipped schedule item syncs
+  std::unordered_map<const cFunctionData *,std::vector<int> > skipped_syncs;
+
+  // A routine skipped by the filters is not checked, but its SYNC still
+  // happens. In global mode it covers every level.
+  void sync_skipped(const cGH *cctkGH,const cFunctionData *attribute) {
+    auto s = skipped_syncs.find(attribute);
+    if(s == skipped_syncs.end()) {
+      std::vector<int> vars;
+      for(int i=0;i<attribute->n_SyncGroups;i++) {
+        const int i0 = CCTK_FirstVarIndexI(attribute->SyncGroups[i]);
+        for(int vi=i0;vi<i0+CCTK_NumVarsInGroupI(attribute->SyncGroups[i]);vi++)
+          vars.push_back(vi);
+      }
+      s = skipped_syncs.insert(std::make_pair(attribute,vars)).first;
+    }
+    if(s->second.empty())
+      return;
+    const int rl = GetRefinementLevel(cctkGH);
+    if(rl >= 0)
+      track_syncs_rl(rl);
+    for(int l=0;l<int(track_syncs.size());l++) {
+      if(rl >= 0 && l != rl)
+        continue;
+      sync_tracker& track = track_syncs[l];
+      if(track.writer.empty())
+        continue;
+      for(auto vi=s->second.begin();vi != s->second.end();++vi) {
+        track.writer[access_slot(*vi,0)] = -1;
+        track.clean[access_slot(*vi,0)] = track.epoch;
+      }
+    }
+  }
+
+  // Have every schedule item of routine r sync group gi from now on
+  void insert_sync(int r,int gi) {
+    const std::vector<const cFunctionData *>& items = routines[r].items;
+    for(auto a=items.begin();a != items.end();++a) {
+      sync_plan& plan = plan_of(*a,routines[r].name);
+      if(plan.fixed || std::find(plan.groups.begin(),plan.groups.end(),gi) != plan.groups.end())
+        continue;
+      plan.groups.push_back(gi);
+      syncs_inserted++;
+      char *group = CCTK_GroupName(gi);
+      RDWR_LOG(LOG_INFO) << "RDWR: Inserting a SYNC of " << group << " after " << routines[r].name;
+      free(group);
+    }
+  }
+
+  // Decide which of its groups the current schedule item syncs. A group
+  // is elided if all of its variables are known to be synced, and are
+  // checked for writes by the routine, so that finish_plan() sees a
+  // write. Calls that elide a group are always checked, see
+  // snapshot_variables().
+  void plan_call(const cFunctionData *attribute,const sync_tracker& track) {
+    DECLARE_CCTK_PARAMETERS;
+    const routine_info& info = routines[rid];
+    sync_plan& plan = plan_of(attribute,info.name);
+    if(plan.fixed)
+      return;
+    plan.now.clear();
+    plan.elided.clear();
+    for(auto g=plan.groups.begin();g != plan.groups.end();++g) {
+      bool synced = elide_syncs;
+      const int i0 = CCTK_FirstVarIndexI(*g);
+      const int iN = i0+CCTK_NumVarsInGroupI(*g);
+      for(int vi=i0;vi<iN && synced;vi++) {
+        const int slot = access_slot(vi,0);
+        const var_tuple vt{vi,0};
+        synced = track.writer[slot] < 0 && track.clean[slot] == track.epoch &&
+          catalog.checked(vt) && std::binary_search(info.check.begin(),info.check.end(),vt);
+      }
+      (synced ? plan.elided : plan.now).push_back(*g);
+    }
+    set_syncs(attribute,plan.now);
+    current_plan = &plan;
+  }
+
+  // Whether the routine declares or was seen to write the interior of
+  // group gi without its ghost zones
+  bool writes_interior(const routine_info& info,int gi) {
+    for(auto c=info.writes.begin();c != info.writes.end();++c)
+      if(c->vt.tl == 0 && (c->where & WH_INTERIOR) != 0 && (c->where & WH_GHOSTS) == 0 &&
+         CCTK_GroupIndexFromVarI(c->vt.vi) == gi)
+        return true;
+    for(auto vi=written_now.begin();vi != written_now.end();++vi)
+      if(CCTK_GroupIndexFromVarI(*vi) == gi)
+        return true;
+    return false;
+  }
+
+  // A SYNC of group gi on the current component would have exchanged
+  // the ghost zones of its grid functions on every face that is not a
+  // physical boundary, one message per face
+  void count_avoided(const cGH *cctkGH,int gi) {
+    double points = 0;
+    int faces = 0;
+    for(int d=0;d<3;d++) {
+      double face = cctkGH->cctk_nghostzones[d];
+      for(int e=0;e<3;e++)
+        if(e != d)
+          face *= cctkGH->cctk_lsh[e];
+      for(int side=0;side<2;side++) {
+        if(face == 0 || cctkGH->cctk_bbox[2*d+side] != 0)
+          continue;
+        faces++;
+        points += face;
+      }
+    }
+    int nvars = 0;
+    const int i0 = CCTK_FirstVarIndexI(gi);
+    for(int vi=i0;vi<i0+CCTK_NumVarsInGroupI(gi);vi++)
+      if(catalog.max_tls[vi] > 0)
+        nvars++;
+    messages_avoided += faces;
+    bytes_avoided += nvars*points*sizeof(CCTK_REAL);
+  }
+
+  // After the routine, and before Carpet syncs: a group it declares or
+  // was seen to write in the interior is synced after all, and so is
+  // every group if the call was not checked. The rest counts as avoided.
+  void finish_plan(const cGH *cctkGH,const cFunctionData *attribute) {
+    sync_plan& plan = *current_plan;
+    current_plan = 0;
+    for(auto g=plan.elided.begin();g != plan.elided.end();++g) {
+      if(rid < 0 || !sampled_call || writes_interior(routines[rid],*g)) {
+        plan.now.push_back(*g);
+      } else {
+        syncs_elided++;
+        count_avoided(cctkGH,*g);
+      }
+    }
+    set_syncs(attribute,plan.now);
+    written_now.clear();
+  }
+
+  // Report the variables the routine that just ran accessed although
+  // it has no clauses for them
+  void disarm_trap(const cGH *cctkGH) {
+    static std::vector<int> accessed;
+    trap_disarm(accessed);
+    for(auto s=accessed.begin();s != accessed.end();++s) {
+      const var_tuple vt{*s / num_tls,*s % num_tls};
+      report(cctkGH,make_finding(FOUND_MISSING_READS,vt,0));
     }
-    return ~chk;
   }
 
   extern "C" int RDWR_pre_call(const cGH *arg1,void *arg2,const cFunctionData *arg3,void *arg4);
   int RDWR_pre_call(const cGH *arg1,void *arg2,const cFunctionData *arg3,void *arg4)
   {
+    // A skipped routine may access everything, and since it may write,
+    // no checksums are carried past it
+    skipped_call = filter_active && filter_skips(arg3);
+    if(skipped_call) {
+      generation++;
+      rid = -1;
+      current_access = all_access.words.data();
+      if(plan_syncs)
+        forget_syncs();
+      sync_skipped(arg1,arg3);
+      return 0;
+    }
+    hook_timer timer;
     CCTK_Checked_reset();
+    generation++;
+    softdirty_call = false;
+    sampled_call = true;
     const cGH *cctkGH = (const cGH *)arg1;
+    DECLARE_CCTK_PARAMETERS;
 
     const cFunctionData *attribute = (const cFunctionData *)arg3;
-    std::cout << "/== " << attribute->thorn << "::" << attribute->routine << " it=" << cctkGH->cctk_iteration << " reffact=" << cctkGH->cctk_timefac << " tl=" << GetTimeLevel(cctkGH) << std::endl;
+    RDWR_LOG(LOG_TRACE) << "/== " << attribute->thorn << "::" << attribute->routine << " it=" << cctkGH->cctk_iteration << " reffact=" << cctkGH->cctk_timefac << " tl=" << GetTimeLevel(cctkGH);
+    if(recording())
+      record_call(cctkGH,attribute);
 
+    current_plan = 0;
     if(GetMap(cctkGH) < 0) {
+      // Global mode is not checked, like a skipped routine
+      rid = -1;
+      current_access = all_access.words.data();
       CCTK_Checked_called();
+      if(plan_syncs)
+        forget_syncs();
       return 0;
     }
 
-    init_MoL();
-
-    routine = attribute->thorn;
-    routine += "::";
-    routine += attribute->routine;
-
-    init_function(attribute);
+    rid = intern_routine(attribute);
+    routine_info& info = routines[rid];
+    info.cost.calls++;
+    current_access = info.access.words.data();
+    context = current_context(cctkGH,attribute);
 
     int comp =  GetRefinementLevel(cctkGH);
 
-    traceVars(cctkGH);
+    watch_vars(cctkGH,rid,info.name,false);
     #if 0
     std::istringstream cns{getenv("DEBUG_INDEXES")};
     int xv,yv,zv;
@@ -429,124 +1206,81 @@ namespace Read_Write_Diagnostics {
     }
     #endif
 
-    std::set<var_tuple> variables_to_check;
-    std::map<var_tuple,int>& reads_m = rclauses[routine];
-    std::set<int> syncs_s = syncs[routine];
-    for(auto i=reads_m.begin();i != reads_m.end();++i) {
-      if(i->second == (WH_INTERIOR|WH_EXTERIOR)) {
-        std::string r = track_syncs[comp][i->first.vi]; // TODO: track SYNC on past timelevels?
-        if(r != "") {
-          std::ostringstream msg;
-          VarName vn(i->first.vi);
-          msg << "error: in routine " << routine << ". Variable " << vn <<
-            " (group " << CCTK_GroupNameFromVarI(i->first.vi) << " tl=" << i->first.tl << ") needs to be synced by " << r;
-          messages.insert(msg.str());
-
-          // Fix syncs
-          #if 0
-          int gi = CCTK_GroupIndexFromVarI(i->first);
-          CCTK_SyncGroupsI(cctkGH,1,&gi);
-          track_syncs[comp][i->first]="";
-          #endif
+    sync_tracker& track = track_syncs_rl(comp);
+    if(plan_syncs && info.writes.empty() && info.reads.empty())
+      track.epoch++;
+    for(auto i=info.reads.begin();i != info.reads.end();++i) {
+      if(i->where == (WH_INTERIOR|WH_EXTERIOR)) {
+        int r = track.writer[access_slot(i->vt.vi,i->vt.tl)];
+        if(r >= 0) {
+          report(cctkGH,make_finding(FOUND_NEEDS_SYNC,i->vt,0),routines[r].name);
+          // The SYNC comes too late for this call, but not for the next
+          if(insert_syncs && i->vt.tl == 0)
+            insert_sync(r,CCTK_GroupIndexFromVarI(i->vt.vi));
         }
       }
-      variables_to_check.insert(i->first);
     }
-    std::map<var_tuple,int>& writes_m = wclauses[routine];
-    for(auto i=writes_m.begin();i != writes_m.end();++i) {
-      if(i->second == WH_INTERIOR) {
-        track_syncs[comp][i->first.vi]=routine;
-      } else if(i->second == (WH_INTERIOR|WH_EXTERIOR)) {
-        track_syncs[comp][i->first.vi]="";
-      }
-      variables_to_check.insert(i->first);
-    }
-    for(auto vp = syncs_s.begin();vp != syncs_s.end();++vp) {
-      std::string r = track_syncs[comp][*vp];
-      if(r == "") {
-        std::ostringstream msg;
-        VarName vn(*vp);
-        msg << "warning: Variable " << vn <<
-          " (group " << CCTK_GroupNameFromVarI(*vp) << ") does not need to be synced by " << routine;
-        messages.insert(msg.str());
-      } else {
-        track_syncs[comp][*vp] = "";
+    for(auto i=info.writes.begin();i != info.writes.end();++i) {
+      const int slot = access_slot(i->vt.vi,i->vt.tl);
+      if(i->where == WH_INTERIOR) {
+        track.writer[slot]=rid;
+      } else if(i->where == (WH_INTERIOR|WH_EXTERIOR)) {
+        track.writer[slot]=-1;
+        track.clean[slot]=track.epoch;
       }
     }
-    // No read-write clauses. Check everything.
-    if(variables_to_check.size()==0) {
-      for(int vi=0;vi < CCTK_NumVars();vi++) {
-        var_tuple vt{vi,0}; // TODO: check other timelevels as well?
-        variables_to_check.insert(vt);
-      }
+    if(plan_syncs)
+      plan_call(attribute,track);
+    for(auto vp = info.syncs.begin();vp != info.syncs.end();++vp) {
+      const int slot = access_slot(*vp,0);
+      if(track.writer[slot] < 0)
+        report(cctkGH,make_finding(FOUND_NEEDLESS_SYNC,var_tuple{*vp,0},0));
+      else if(current_plan == 0)
+        track.writer[slot] = -1;
     }
-
-    for(auto i = variables_to_check.begin();i != variables_to_check.end();++i) {
-       int vi = i->vi;
-       int tl = i->tl;
-       void *data = CCTK_VarDataPtrI(cctkGH,tl,vi);
-       if(data == 0) continue;
-       int type = CCTK_GroupTypeFromVarI(vi);
-       if(type == CCTK_GF && CCTK_VarTypeSize(CCTK_VarTypeI(vi)) == sizeof(CCTK_REAL)) {
-       unsigned long *ldata = (unsigned long*)data;
-       cksum_t c = compute_cksum(cctkGH,ldata,vi);
-       cksums[vi] = c;
+    // What the schedule item syncs now
+    if(current_plan != 0) {
+      for(auto g=current_plan->now.begin();g != current_plan->now.end();++g) {
+        const int i0 = CCTK_FirstVarIndexI(*g);
+        for(int vi=i0;vi<i0+CCTK_NumVarsInGroupI(*g);vi++) {
+          track.writer[access_slot(vi,0)] = -1;
+          track.clean[access_slot(vi,0)] = track.epoch;
+        }
       }
     }
+    snapshot_variables(cctkGH);
+    if(trap_undeclared)
+      arm_trap(cctkGH);
+    info.cost.pre += hook_clock() - timer.start;
     return 0;
   }
 
   extern "C" int RDWR_post_call(const cGH *arg1,void *arg2,const cFunctionData * arge,void *arg4);
   int RDWR_post_call(const cGH *arg1,void *arg2,const cFunctionData * arg3,void *arg4)
   {
+    if(skipped_call)
+      return 0;
+    hook_timer timer;
     const cGH *cctkGH = (const cGH *)arg1;
     const cFunctionData *attribute = (const cFunctionData *)arg3;
     if(CCTK_Checked_get() == 0) {
-      std::cout << "RDWR: No check called for " << attribute->thorn << "::" << attribute->routine << "\n";
+      RDWR_LOG(LOG_WARNING) << "RDWR: No check called for " << attribute->thorn << "::" << attribute->routine;
     }
     CCTK_Checked_reset();
 
-    std::set<var_tuple> variables_to_check;
-    std::map<var_tuple,int>& reads_m = rclauses[routine];
-    for(auto i=reads_m.begin();i != reads_m.end();++i) {
-      variables_to_check.insert(i->first);
-    }
-    std::map<var_tuple,int>& writes_m = wclauses[routine];
-    for(auto i=writes_m.begin();i != writes_m.end();++i) {
-      variables_to_check.insert(i->first);
-    }
-    // No read-write clause. Check everything.
-    if(variables_to_check.size()==0) {
-      for(int vi=0;vi < CCTK_NumVars();vi++) {
-        var_tuple vt{vi,0}; // TODO: should I check all timelevels?
-        variables_to_check.insert(vt);
-      }
-    }
-
-    for(auto i = variables_to_check.begin();i != variables_to_check.end();++i) {
-       int vi = i->vi;
-       int tl = i->tl;
-       void *data = CCTK_VarDataPtrI(cctkGH,tl,vi);
-       if(data == 0) continue;
-       int type = CCTK_GroupTypeFromVarI(vi);
-       if(type == CCTK_GF && CCTK_VarTypeSize(CCTK_VarTypeI(vi)) == sizeof(CCTK_REAL)) {
-       unsigned long *ldata = (unsigned long*)data;
-       cksum_t c = compute_cksum(cctkGH,ldata,vi);
-       cksum_t cn = cksums[vi];
-        if(cn != c) {
-          int where=0;
-          if(cn.out != c.out)
-            where |= WH_EXTERIOR;
-          if(cn.in != c.in)
-            where |= WH_INTERIOR;
-          observed_writes[routine][*i] |= where;
-        }
-      }
+    if(rid >= 0) {
+      disarm_trap(cctkGH);
+      if(sampled_call)
+        sampling_checked(observe_writes(cctkGH));
+      const double start = hook_clock();
+      wclause_diagnostic(cctkGH);
+      routines[rid].cost.wclause += hook_clock() - start;
     }
-    wclause_diagnostic();
+    if(current_plan != 0)
+      finish_plan(cctkGH,attribute);
   
   
-    traceVars(cctkGH);
+    watch_vars(cctkGH,rid,rid >= 0 ? routines[rid].name : "",true);
     #if 0
     std::istringstream cns{getenv("DEBUG_INDEXES")};
     int xv,yv,zv;
@@ -574,53 +1308,375 @@ namespace Read_Write_Diagnostics {
     }
     #endif
 
-    std::cout << "\\== " << attribute->thorn << "::" << attribute->routine << std::endl;
+    if(recording())
+      record_done(rid >= 0 && sampled_call);
+    RDWR_LOG(LOG_TRACE) << "\\== " << attribute->thorn << "::" << attribute->routine;
+    if(rid >= 0)
+      routines[rid].cost.post += hook_clock() - timer.start;
     return 0;
   }
 
+  extern "C" int RDWR_VarAccessI(const cGH *gh,int tl,int vi) {
+    if(current_access == 0)
+      build_catalog();
+    if(vi < 0 || vi >= num_vars || tl < 0 || tl >= num_tls)
+      return 0;
+    const int slot = access_slot(vi,tl);
+    return (current_access[slot >> 5] >> ((slot & 31)*2)) & 3;
+  }
+
+  bool time_varptr = false;    // overhead_varptr
+
+  inline void *var_data_ptr(const cGH *gh,int tl,int vi) {
+    if(RDWR_VarAccessI(gh,tl,vi) == 0)
+      return 0;
+    return CCTK_VarDataPtrI(gh,tl,vi);
+  }
+
+  // Only every 64th call is timed, since the clock costs more than the
+  // call itself. Kept out of line, off the path without overhead_varptr.
+  __attribute__((noinline)) void *timed_var_data_ptr(const cGH *gh,int tl,int vi) {
+    if(rid < 0)
+      return var_data_ptr(gh,tl,vi);
+    overhead_t& cost = routines[rid].cost;
+    if((cost.varptr_calls++ & 63) != 0)
+      return var_data_ptr(gh,tl,vi);
+    const double start = hook_clock();
+    void *data = var_data_ptr(gh,tl,vi);
+    cost.varptr += 64*(hook_clock() - start);
+    return data;
+  }
+
   extern "C" void *RDWR_VarDataPtrI(const cGH *gh,int tl,int vi) {
-    bool found = false;
-    std::map<var_tuple,int>& reads_m = rclauses[routine];
-    //int read_mask = 0;
-    var_tuple vt{vi,tl};
-    if(reads_m.find(vt) == reads_m.end()) {
-      std::map<var_tuple,int>& writes_m = wclauses[routine];
-      if(writes_m.find(vt) == writes_m.end()) {
-        ; // not found in either reads or writes
+    if(__builtin_expect(time_varptr,0))
+      return timed_var_data_ptr(gh,tl,vi);
+    return var_data_ptr(gh,tl,vi);
+  }
+
+  // Fill in values[RDWR_OVERHEAD_*] for thorn::routine, or for the sum
+  // of all routines if routine is empty. Returns the number of values
+  // filled in, or -1 for an unknown routine.
+  extern "C" CCTK_INT RDWR_QueryOverhead(CCTK_STRING routine,CCTK_REAL *values,CCTK_INT nvalues) {
+    overhead_t sum;
+    const bool all = *routine == 0;
+    if(!all && routine_names.find(routine) == routine_names.end())
+      return -1;
+    for(auto r=routines.begin();r != routines.end();++r) {
+      if(!all && r->name != routine)
+        continue;
+      const overhead_t& c = r->cost;
+      sum.calls += c.calls;
+      sum.checks += c.checks;
+      sum.pre += c.pre;
+      sum.post += c.post;
+      sum.wclause += c.wclause;
+      sum.varptr_calls += c.varptr_calls;
+      sum.varptr += c.varptr;
+      sum.bytes += c.bytes;
+      sum.variables += c.variables;
+      sum.timelevels += c.timelevels;
+      sum.cache_hits += c.cache_hits;
+    }
+    const CCTK_REAL v[RDWR_OVERHEAD_NVALUES] = {
+      CCTK_REAL(sum.calls),CCTK_REAL(sum.checks),sum.pre,sum.post,sum.wclause,
+      CCTK_REAL(sum.varptr_calls),sum.varptr,sum.bytes,CCTK_REAL(sum.variables),
+      CCTK_REAL(sum.timelevels),CCTK_REAL(sum.cache_hits)
+    };
+    const int n = std::max(0,std::min(int(nvalues),int(RDWR_OVERHEAD_NVALUES)));
+    std::copy(v,v+n,values);
+    return n;
+  }
+
+  // The routines that cost this process the most
+  void show_overhead() {
+    DECLARE_CCTK_PARAMETERS;
+    if(overhead_table == 0 || routines.empty())
+      return;
+    std::vector<int> order(routines.size());
+    for(size_t n=0;n<order.size();n++)
+      order[n] = n;
+    auto total = [](const overhead_t& c) { return c.pre + c.post + c.varptr; };
+    std::sort(order.begin(),order.end(),[&](int a,int b) {
+      return total(routines[a].cost) > total(routines[b].cost);
+    });
+    if(int(order.size()) > overhead_table)
+      order.resize(overhead_table);
+    char line[400];
+    RDWR_LOG(LOG_INFO) << "RDWR: Overhead of the most expensive routines on this process";
+    snprintf(line,sizeof(line),"%9s %9s %9s %9s %9s %9s %9s %9s %9s %9s  %s",
+             "ms","pre","post","wclause","varptr","calls","checks","MB","vars","hits","routine");
+    RDWR_LOG(LOG_INFO) << line;
+    for(auto n=order.begin();n != order.end();++n) {
+      const overhead_t& c = routines[*n].cost;
+      snprintf(line,sizeof(line),"%9.1f %9.1f %9.1f %9.1f %9.1f %9ld %9ld %9.1f %9ld %9ld  %s",
+               1e3*total(c),1e3*c.pre,1e3*c.post,1e3*c.wclause,1e3*c.varptr,c.calls,c.checks,
+               c.bytes*1e-6,c.variables,c.cache_hits,routines[*n].name.c_str());
+      RDWR_LOG(LOG_INFO) << line;
+    }
+    CCTK_REAL sum[RDWR_OVERHEAD_NVALUES];
+    RDWR_QueryOverhead("",sum,RDWR_OVERHEAD_NVALUES);
+    snprintf(line,sizeof(line),"%9.1f in %ld calls of %zu routines, %.1f MB hashed or compared, %ld past timelevels",
+             1e3*(sum[RDWR_OVERHEAD_PRE]+sum[RDWR_OVERHEAD_POST]+sum[RDWR_OVERHEAD_VARPTR]),
+             long(sum[RDWR_OVERHEAD_CALLS]),routines.size(),sum[RDWR_OVERHEAD_BYTES]*1e-6,
+             long(sum[RDWR_OVERHEAD_TIMELEVELS]));
+    RDWR_LOG(LOG_INFO) << line;
+  }
+
+  // The smallest region that schedule.ccl can express and that
+  // covers where, see compute_clauses()
+  inline int clause_where(int where) {
+    if(where == WH_INTERIOR || where == WH_BOUNDARY || where == WH_NOWHERE)
+      return where;
+    if((where & WH_INTERIOR) == 0)
+      return WH_EXTERIOR;
+    if((where & WH_GHOSTS) == 0)
+      return WH_INTERIOR|WH_BOUNDARY;
+    return WH_EVERYWHERE;
+  }
+
+  inline const char *clause_region(int where) {
+    return where == (WH_INTERIOR|WH_BOUNDARY) ? "interiorwithboundary" : wh_name(where);
+  }
+
+  // The clauses of one routine, merged over all processes
+  struct clause_summary {
+    std::map<var_tuple,int> observed;     // writes, as clause regions
+    std::map<var_tuple,int> writes, reads;
+    std::set<var_tuple> checked;          // declared writes that were checked
+    std::set<var_tuple> undeclared_reads;
+  };
+
+  // Write clauses as a JSON array of strings, naming the whole group
+  // where all of its variables share the timelevel and region
+  void write_clauses(FILE *file,const std::map<var_tuple,int>& clauses) {
+    std::set<var_tuple> done;
+    const char *sep = "";
+    fprintf(file,"[");
+    for(auto c=clauses.begin();c != clauses.end();++c) {
+      if(done.count(c->first) != 0)
+        continue;
+      const int gi = CCTK_GroupIndexFromVarI(c->first.vi);
+      const int i0 = CCTK_FirstVarIndexI(gi);
+      const int nvars = CCTK_NumVarsInGroupI(gi);
+      bool whole = nvars > 1;
+      for(int vi=i0;vi<i0+nvars && whole;vi++) {
+        auto v = clauses.find(var_tuple{vi,c->first.tl});
+        whole = v != clauses.end() && v->second == c->second;
+      }
+      char *name;
+      if(whole) {
+        name = CCTK_GroupName(gi);
+        for(int vi=i0;vi<i0+nvars;vi++)
+          done.insert(var_tuple{vi,c->first.tl});
       } else {
-        found = true;
+        name = CCTK_FullName(c->first.vi);
       }
-    } else {
-      //read_mask = reads_m[vi];
-      found = true;
+      fprintf(file,"%s\"%s%s(%s)\"",sep,name,tl_suffix(c->first.tl).c_str(),clause_region(c->second));
+      free(name);
+      sep = ", ";
     }
-    int type = CCTK_GroupTypeFromVarI(vi);
-    if(type == CCTK_GF && CCTK_VarTypeSize(CCTK_VarTypeI(vi)) == sizeof(CCTK_REAL)) {
-      ; // we only check grid functions of this type
-    } else {
-      found = true;
+    fprintf(file,"]");
+  }
+
+  // Write the clauses the routines were seen to need to clause_file,
+  // one object per routine, with how they differ from schedule.ccl:
+  //
+  //   "writes", "reads":      the suggested clauses
+  //   "missing_writes":       observed, but not declared
+  //   "overdeclared_writes":  declared and checked, but never observed
+  //   "wrong_region_writes":  declared with another region than observed
+  //   "unchecked_writes":     declared, but not checked (no storage or
+  //                           not a real grid function), kept as is
+  //   "missing_reads":        accessed without clauses (trap_undeclared)
+  //
+  // Reads cannot be observed, so the declared READS are kept. Writes of
+  // unchanged values are not observed either.
+  void write_clause_file(const char *name,const std::vector<finding>& all,
+                         std::map<uint64_t,std::string>& names) {
+    std::map<std::string,clause_summary> summaries;
+    for(auto f=all.begin();f != all.end();++f) {
+      const var_tuple vt{f->vi,f->tl};
+      switch(f->kind) {
+      case FOUND_OBSERVED_WRITE:
+        summaries[names[f->routine]].observed[vt] |= f->where;
+        break;
+      case FOUND_DECLARED_WRITE: {
+        clause_summary& s = summaries[names[f->routine]];
+        s.writes[vt] = f->where;
+        if(f->declared != 0)
+          s.checked.insert(vt);
+        break;
+      }
+      case FOUND_DECLARED_READ:
+        summaries[names[f->routine]].reads[vt] = f->where;
+        break;
+      case FOUND_MISSING_READS:
+        summaries[names[f->routine]].undeclared_reads.insert(vt);
+        break;
+      default:
+        break;
+      }
     }
-    if(found) {
-      return (CCTK_REAL*)CCTK_VarDataPtrI(gh,tl,vi);
-    } else {
-      return 0;
+    FILE *file = fopen(name,"w");
+    if(file == 0) {
+      CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot create %s",name);
+      return;
     }
+    fprintf(file,"{\n  \"routines\": [");
+    const char *sep = "\n";
+    for(auto r=summaries.begin();r != summaries.end();++r) {
+      clause_summary& s = r->second;
+      std::map<var_tuple,int> writes, reads = s.reads, missing, over, unchecked, missing_reads;
+      std::map<var_tuple,std::pair<int,int> > wrong;
+      for(auto o=s.observed.begin();o != s.observed.end();++o) {
+        const int where = clause_where(o->second);
+        writes[o->first] = where;
+        auto d = s.writes.find(o->first);
+        if(d == s.writes.end())
+          missing[o->first] = where;
+        else if(d->second != where)
+          wrong[o->first] = std::make_pair(d->second,where);
+      }
+      for(auto d=s.writes.begin();d != s.writes.end();++d) {
+        if(s.observed.count(d->first) != 0)
+          continue;
+        if(s.checked.count(d->first) != 0) {
+          over[d->first] = d->second;
+        } else {
+          unchecked[d->first] = d->second;
+          writes[d->first] = d->second;
+        }
+      }
+      for(auto u=s.undeclared_reads.begin();u != s.undeclared_reads.end();++u) {
+        if(s.reads.count(*u) == 0 && s.writes.count(*u) == 0) {
+          missing_reads[*u] = WH_EVERYWHERE;
+          reads[*u] = WH_EVERYWHERE;
+        }
+      }
+      fprintf(file,"%s    {\n      \"routine\": \"%s\",\n      \"writes\": ",sep,r->first.c_str());
+      write_clauses(file,writes);
+      fprintf(file,",\n      \"reads\": ");
+      write_clauses(file,reads);
+      fprintf(file,",\n      \"missing_writes\": ");
+      write_clauses(file,missing);
+      fprintf(file,",\n      \"overdeclared_writes\": ");
+      write_clauses(file,over);
+      fprintf(file,",\n      \"wrong_region_writes\": [");
+      const char *wsep = "";
+      for(auto w=wrong.begin();w != wrong.end();++w) {
+        char *vname = CCTK_FullName(w->first.vi);
+        fprintf(file,"%s{\"variable\": \"%s%s\", \"declared\": \"%s\", \"observed\": \"%s\"}",
+                wsep,vname,tl_suffix(w->first.tl).c_str(),
+                clause_region(w->second.first),clause_region(w->second.second));
+        free(vname);
+        wsep = ", ";
+      }
+      fprintf(file,"],\n      \"unchecked_writes\": ");
+      write_clauses(file,unchecked);
+      fprintf(file,",\n      \"missing_reads\": ");
+      write_clauses(file,missing_reads);
+      fprintf(file,"\n    }");
+      sep = ",\n";
+    }
+    fprintf(file,"\n  ]\n}\n");
+    fclose(file);
   }
 
+  // Merge the findings of all processes. Process 0 writes them to
+  // report_file and to stderr, with the number of processes that made
+  // each finding and the first one that did, and the suggested clauses
+  // to clause_file.
   extern "C" void RDWR_ShowDiagnostics(CCTK_ARGUMENTS) {
+    DECLARE_CCTK_PARAMETERS;
+    for(auto r=routines.begin();r != routines.end();++r) {
+      for(auto o=r->observed.begin();o != r->observed.end();++o) {
+        finding f = make_finding(FOUND_OBSERVED_WRITE,o->vt,o->where);
+        f.first_iteration = o->first_iteration;
+        add_finding(f,r->name,"");
+      }
+      if(*clause_file == 0)
+        continue;
+      for(auto c=r->writes.begin();c != r->writes.end();++c) {
+        finding f = make_finding(FOUND_DECLARED_WRITE,c->vt,c->where);
+        f.declared = r->cost.checks > 0 && catalog.checked(c->vt);
+        add_finding(f,r->name,"");
+      }
+      for(auto c=r->reads.begin();c != r->reads.end();++c)
+        add_finding(make_finding(FOUND_DECLARED_READ,c->vt,c->where),r->name,"");
+    }
+    if(reuse_cksums) {
+      RDWR_LOG(LOG_INFO) << "RDWR: " << cksums_reused << " pre-call checksums reused, "
+        << cksums_computed << " computed";
+    }
+    show_overhead();
+    if(plan_syncs) {
+      RDWR_LOG(LOG_INFO) << "RDWR: " << syncs_elided << " group SYNCs elided, avoiding about "
+        << messages_avoided << " messages and " << bytes_avoided*1e-6 << " MB; "
+        << syncs_inserted << " SYNCs inserted";
+    }
+    std::vector<finding> all;
+    std::map<uint64_t,std::string> names;
+    reduce_findings(all,names);
+    record_close();
+    // The summary goes to stderr after everything queued
+    log_flush();
+    if(CCTK_MyProc(cctkGH) != 0)
+      return;
+    if(*clause_file != 0)
+      write_clause_file(clause_file,all,names);
+    FILE *file = 0;
+    if(*report_file != 0) {
+      file = fopen(report_file,"w");
+      if(file == 0)
+        CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot create %s",report_file);
+    }
     std::cerr << "RDWR Diagnostics:" << std::endl;
-    for(auto i=messages.begin();i != messages.end();++i) {
-      std::cerr << *i << std::endl;
+    for(auto f=all.begin();f != all.end();++f) {
+      if(f->kind == FOUND_DECLARED_WRITE || f->kind == FOUND_DECLARED_READ)
+        continue;
+      std::ostringstream line;
+      line << format_finding(*f,names[f->routine],f->other != 0 ? names[f->other] : "")
+        << " [" << f->nranks << " process" << (f->nranks == 1 ? "" : "es")
+        << ", first on " << f->first_rank << " at iteration " << f->first_iteration << "]";
+      if(file != 0)
+        fprintf(file,"%s\n",line.str().c_str());
+      if(f->kind != FOUND_OBSERVED_WRITE)
+        std::cerr << line.str() << std::endl;
     }
-    return;
+    if(file != 0)
+      fclose(file);
   }
 
   extern "C" int RDWR_AddDiagnosticCalls(void) {
+    DECLARE_CCTK_PARAMETERS;
+    build_catalog();
+    watch_compile();
+    filter_compile();
+    plan_syncs = elide_syncs || insert_syncs;
+    time_varptr = overhead_varptr;
+    const char *engine = select_cksum_engine(cksum_engine,localize_writes);
+    RDWR_LOG(LOG_INFO) << "RDWR: Using the " << engine << " checksum engine";
+    if(*record_schedule != 0)
+      record_open(record_schedule);
+    if(trap_undeclared && !trap_install())
+      CCTK_WARN(1,"Cannot install the SIGSEGV handler for trap_undeclared");
     Carpet::Carpet_RegisterScheduleWrapper((Carpet::func)RDWR_pre_call,(Carpet::func)RDWR_post_call);
-    std::cout << "RDWR: Hooks added" << std::endl;
+    RDWR_LOG(LOG_INFO) << "RDWR: Hooks added";
     return 0;
   }
 
+  extern "C" void RDWR_BuildCatalog(CCTK_ARGUMENTS) {
+    DECLARE_CCTK_ARGUMENTS;
+    build_catalog();
+    for(int vi=0;vi<num_vars;vi++) {
+      if(catalog.max_tls[vi] == 0)
+        continue;
+      int active = CCTK_ActiveTimeLevelsVI(cctkGH,vi);
+      if(active > 0)
+        catalog.active_tls[vi] = std::min(active,catalog.max_tls[vi]);
+    }
+  }
+
   int is_white(char c) {
     return c == ' ' || c == '\n' || c == '\t' || c == '\r';
   }
@@ -654,12 +1710,12 @@ namespace Read_Write_Diagnostics {
     {
       int var = CCTK_VarIndex(out.c_str());
       if(var < 0) {
-        std::cout << "RDWR: Zero_init skips (" << out << ") no such variable.\n";
+        RDWR_LOG(LOG_INFO) << "RDWR: Zero_init skips (" << out << ") no such variable.";
         continue;
       }
       int group = CCTK_GroupIndexFromVarI(var);
       if(group >= 0) {
-          std::cout << "RDWR: Turn on group storage\n";
+          RDWR_LOG(LOG_INFO) << "RDWR: Turn on group storage";
           CCTK_EnableGroupStorageI(cctkGH,group);
       }
     }
@@ -674,20 +1730,20 @@ namespace Read_Write_Diagnostics {
     {
       int var = CCTK_VarIndex(out.c_str());
       if(var < 0) {
-        std::cout << "RDWR: Zero_init skips " << out << " no such variable.\n";
+        RDWR_LOG(LOG_INFO) << "RDWR: Zero_init skips " << out << " no such variable.";
         continue;
       }
       void *data = CCTK_VarDataPtrI(cctkGH,0,var);
       if(data == nullptr) {
         int group = CCTK_GroupIndexFromVarI(var);
         if(group >= 0) {
-          std::cout << "RDWR: Turn on group storage\n";
+          RDWR_LOG(LOG_INFO) << "RDWR: Turn on group storage";
           CCTK_EnableGroupStorageI(cctkGH,group);
         }
       }
       data = CCTK_VarDataPtrI(cctkGH,0,var);
       if(data == 0) {
-        std::cout << "RDWR: Zero_init skips " << out << " nullptr.\n";
+        RDWR_LOG(LOG_INFO) << "RDWR: Zero_init skips " << out << " nullptr.";
         continue;
       }
       int type = CCTK_GroupTypeFromVarI(var);
@@ -702,7 +1758,7 @@ namespace Read_Write_Diagnostics {
           }
         }
         Carpet_SetValidRegion(var,0,WH_EVERYWHERE);
-        std::cout << "Zero_init of " << out << " to Everywhere\n";
+        RDWR_LOG(LOG_INFO) << "Zero_init of " << out << " to Everywhere";
       }
     }
   } // end
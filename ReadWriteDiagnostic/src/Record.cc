@@ -0,0 +1,129 @@
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <cctk.h>
+#include <cctk_Functions.h>
+
+#include "Record.hh"
+
+namespace Read_Write_Diagnostics {
+
+  extern "C" int GetRefinementLevel(const cGH*);
+
+  namespace {
+    FILE *file = 0;
+    bool has_component = false;
+    // Routines are told apart by their schedule item, like in the hooks
+    std::map<const cFunctionData *,int> ids;
+
+    const char *group_type(int type) {
+      if(type == CCTK_GF) return "gf";
+      if(type == CCTK_ARRAY) return "array";
+      return "scalar";
+    }
+
+    // Names and clauses are written as single words
+    void write_word(const char *s) {
+      fputc(' ',file);
+      if(s == 0 || *s == 0) {
+        fputc('-',file);
+        return;
+      }
+      for(;*s != 0;s++)
+        if(*s != ' ' && *s != '\t' && *s != '\n')
+          fputc(*s,file);
+    }
+
+    void write_clauses(int n,const char **clauses) {
+      fprintf(file," %d",n);
+      for(int i=0;i<n;i++)
+        write_word(clauses[i]);
+    }
+
+    void write_ints(const int *v,int n) {
+      for(int i=0;i<n;i++)
+        fprintf(file," %d",v[i]);
+    }
+  }
+
+  void record_open(const char *base) {
+    char name[1024];
+    snprintf(name,sizeof(name),"%s.%d.txt",base,CCTK_MyProc(NULL));
+    file = fopen(name,"w");
+    if(file == 0) {
+      CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot create %s",name);
+      return;
+    }
+    has_component = CCTK_IsFunctionAliased("GetLocalComponent");
+    fprintf(file,"rdwr-schedule 1\n");
+    const int ngroups = CCTK_NumGroups();
+    for(int gi=0;gi<ngroups;gi++) {
+      const int first = CCTK_FirstVarIndexI(gi);
+      const int nvars = CCTK_NumVarsInGroupI(gi);
+      char *gname = CCTK_GroupName(gi);
+      fprintf(file,"group %d",gi);
+      write_word(gname);
+      free(gname);
+      if(nvars > 0 && first >= 0) {
+        fprintf(file," %s %d %d %d",group_type(CCTK_GroupTypeFromVarI(first)),
+                CCTK_VarTypeSize(CCTK_VarTypeI(first)),CCTK_MaxTimeLevelsVI(first),nvars);
+        for(int vi=first;vi<first+nvars;vi++) {
+          char *vname = CCTK_FullName(vi);
+          write_word(vname);
+          free(vname);
+        }
+      } else {
+        fprintf(file," scalar 0 0 0");
+      }
+      fputc('\n',file);
+    }
+  }
+
+  void record_close() {
+    if(file != 0)
+      fclose(file);
+    file = 0;
+  }
+
+  bool recording() {
+    return file != 0;
+  }
+
+  void record_call(const cGH *cctkGH,const cFunctionData *attribute) {
+    auto f = ids.find(attribute);
+    if(f == ids.end()) {
+      const int id = ids.size();
+      f = ids.insert(std::make_pair(attribute,id)).first;
+      fprintf(file,"routine %d",id);
+      write_word(attribute->implementation);
+      write_word(attribute->thorn);
+      write_word(attribute->routine);
+      write_word(attribute->where);
+      write_clauses(attribute->n_WritesClauses,attribute->WritesClauses);
+      write_clauses(attribute->n_ReadsClauses,attribute->ReadsClauses);
+      fprintf(file," %d",attribute->n_SyncGroups);
+      write_ints(attribute->SyncGroups,attribute->n_SyncGroups);
+      fputc('\n',file);
+    }
+    const int map = GetMap(cctkGH);
+    const int component = map >= 0 && has_component ? GetLocalComponent(cctkGH) : 0;
+    fprintf(file,"call %d %d %d %d %d %d %d",f->second,cctkGH->cctk_iteration,
+            GetRefinementLevel(cctkGH),map,component,(int)GetTimeLevel(cctkGH),cctkGH->cctk_timefac);
+    write_ints(cctkGH->cctk_lsh,3);
+    write_ints(cctkGH->cctk_ash,3);
+    write_ints(cctkGH->cctk_lbnd,3);
+    write_ints(cctkGH->cctk_gsh,3);
+    write_ints(cctkGH->cctk_nghostzones,3);
+    write_ints(cctkGH->cctk_bbox,6);
+    write_ints(cctkGH->cctk_levfac,3);
+    fputc('\n',file);
+  }
+
+  void record_write(int vi,int tl,int where) {
+    fprintf(file,"write %d %d %d\n",vi,tl,where);
+  }
+
+  void record_done(bool checked) {
+    fprintf(file,"done %d\n",checked ? 1 : 0);
+  }
+}
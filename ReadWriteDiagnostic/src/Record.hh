@@ -0,0 +1,42 @@
+#ifndef RDWR_RECORD_HH
+#define RDWR_RECORD_HH
+
+#include <cctk.h>
+#include <cctk_Schedule.h>
+
+namespace Read_Write_Diagnostics {
+
+  // Recording of the wrapped routines, for bench/replay. Each process
+  // writes a text file, one record per line:
+  //
+  //   rdwr-schedule 1
+  //   group <gi> <name> <gf|array|scalar> <type bytes> <timelevels> <nvars> <var names>
+  //   routine <id> <implementation> <thorn> <routine> <where>
+  //           <n> <WRITES> <n> <READS> <n> <SYNC group indices>
+  //   call <id> <iteration> <rl> <map> <component> <timelevel> <timefac>
+  //        <lsh> <ash> <lbnd> <gsh> <nghostzones> <bbox> <levfac>
+  //   write <vi> <tl> <where>
+  //   done <checked>
+  //
+  // Every group comes first, in index order. A routine is recorded when
+  // it is first called, a call with the writes observed in it. Calls
+  // that were not checked (see sampling) have no writes.
+
+  // Open <base>.<rank>.txt and write the groups
+  void record_open(const char *base);
+
+  void record_close();
+
+  bool recording();
+
+  // At the start of a wrapped routine
+  void record_call(const cGH *cctkGH,const cFunctionData *attribute);
+
+  // A write observed in the current call
+  void record_write(int vi,int tl,int where);
+
+  // At the end of a wrapped routine
+  void record_done(bool checked);
+}
+
+#endif
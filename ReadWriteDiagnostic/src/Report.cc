@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <cctk.h>
+#ifdef HAVE_CAPABILITY_MPI
+#include <mpi.h>
+#endif
+
+#include "Report.hh"
+
+namespace Read_Write_Diagnostics {
+
+  namespace {
+    inline auto key(const finding& f)
+      -> decltype(std::tie(f.kind,f.routine,f.other,f.vi,f.tl,f.where,f.declared,f.rl)) {
+      return std::tie(f.kind,f.routine,f.other,f.vi,f.tl,f.where,f.declared,f.rl);
+    }
+
+    struct key_less {
+      bool operator()(const finding& a,const finding& b) const {
+        return key(a) < key(b);
+      }
+    };
+
+    // The map keys only hold the key fields that matter, see key()
+    std::map<finding,finding,key_less> local;
+    std::map<uint64_t,std::string> local_names;
+
+    // Fold b into a, which has the same key
+    void merge(finding& a,const finding& b) {
+      for(int d=0;d<3;d++) {
+        a.lo[d] = std::min(a.lo[d],b.lo[d]);
+        a.hi[d] = std::max(a.hi[d],b.hi[d]);
+      }
+      a.nranks += b.nranks;
+      if(std::tie(b.first_iteration,b.first_rank) < std::tie(a.first_iteration,a.first_rank)) {
+        a.first_iteration = b.first_iteration;
+        a.first_rank = b.first_rank;
+      }
+    }
+
+#ifdef HAVE_CAPABILITY_MPI
+    // [count][findings][count][hash,length,name]...
+    void pack(const std::vector<finding>& fs,const std::map<uint64_t,std::string>& names,std::vector<char>& buf) {
+      buf.clear();
+      auto put = [&buf](const void *p,size_t n) {
+        buf.insert(buf.end(),(const char *)p,(const char *)p+n);
+      };
+      uint64_t n = fs.size();
+      put(&n,sizeof(n));
+      put(fs.data(),n*sizeof(finding));
+      n = names.size();
+      put(&n,sizeof(n));
+      for(auto i=names.begin();i != names.end();++i) {
+        uint64_t len = i->second.size();
+        put(&i->first,sizeof(i->first));
+        put(&len,sizeof(len));
+        put(i->second.data(),len);
+      }
+    }
+
+    void unpack(const std::vector<char>& buf,std::vector<finding>& fs,std::map<uint64_t,std::string>& names) {
+      const char *p = buf.data();
+      auto get = [&p](void *q,size_t n) {
+        memcpy(q,p,n);
+        p += n;
+      };
+      uint64_t n;
+      get(&n,sizeof(n));
+      fs.resize(n);
+      get(fs.data(),n*sizeof(finding));
+      get(&n,sizeof(n));
+      for(uint64_t i=0;i<n;i++) {
+        uint64_t hash, len;
+        get(&hash,sizeof(hash));
+        get(&len,sizeof(len));
+        names[hash].assign(p,len);
+        p += len;
+      }
+    }
+#endif
+  }
+
+  uint64_t name_hash(const std::string& name) {
+    uint64_t h = 14695981039346656037UL;
+    for(size_t i=0;i<name.size();i++)
+      h = (h ^ (unsigned char)name[i]) * 1099511628211UL;
+    return h;
+  }
+
+  bool add_finding(finding f,const std::string& routine,const std::string& other) {
+    f.routine = name_hash(routine);
+    local_names[f.routine] = routine;
+    if(other.empty()) {
+      f.other = 0;
+    } else {
+      f.other = name_hash(other);
+      local_names[f.other] = other;
+    }
+    f.nranks = 1;
+    f.first_rank = CCTK_MyProc(NULL);
+    auto i = local.find(f);
+    if(i == local.end()) {
+      local.insert(std::make_pair(f,f));
+      return true;
+    }
+    finding& old = i->second;
+    bool grew = false;
+    for(int d=0;d<3;d++)
+      grew |= f.lo[d] < old.lo[d] || f.hi[d] > old.hi[d];
+    f.nranks = 0;
+    merge(old,f);
+    return grew;
+  }
+
+  void reduce_findings(std::vector<finding>& all,std::map<uint64_t,std::string>& names) {
+    all.clear();
+    for(auto i=local.begin();i != local.end();++i)
+      all.push_back(i->second);
+    names = local_names;
+#ifdef HAVE_CAPABILITY_MPI
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+    MPI_Comm_size(MPI_COMM_WORLD,&size);
+    const int tag = 0x5244; // "RD"
+    std::vector<char> buf;
+    std::vector<finding> theirs;
+    for(int step=1;step<size;step*=2) {
+      if((rank & step) != 0) {
+        pack(all,names,buf);
+        MPI_Send(buf.data(),buf.size(),MPI_BYTE,rank-step,tag,MPI_COMM_WORLD);
+        all.clear();
+        names.clear();
+        return;
+      }
+      if(rank+step >= size)
+        continue;
+      MPI_Status status;
+      int count;
+      MPI_Probe(rank+step,tag,MPI_COMM_WORLD,&status);
+      MPI_Get_count(&status,MPI_BYTE,&count);
+      buf.resize(count);
+      MPI_Recv(buf.data(),count,MPI_BYTE,rank+step,tag,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+      unpack(buf,theirs,names);
+      // Both lists are sorted by key
+      std::vector<finding> merged;
+      merged.reserve(all.size()+theirs.size());
+      key_less less;
+      auto a = all.begin(), b = theirs.begin();
+      while(a != all.end() || b != theirs.end()) {
+        if(b == theirs.end() || (a != all.end() && less(*a,*b))) {
+          merged.push_back(*a++);
+        } else if(a == all.end() || less(*b,*a)) {
+          merged.push_back(*b++);
+        } else {
+          merged.push_back(*a++);
+          merge(merged.back(),*b++);
+        }
+      }
+      all.swap(merged);
+    }
+#endif
+  }
+}
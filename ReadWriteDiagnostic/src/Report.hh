@@ -0,0 +1,47 @@
+#ifndef RDWR_REPORT_HH
+#define RDWR_REPORT_HH
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Read_Write_Diagnostics {
+
+  // The findings of all processes are merged at CCTK_TERMINATE by a
+  // binomial tree reduction of these fixed-size records. Routines are
+  // identified by a hash of their name, since their ids differ between
+  // processes; the names travel along in a small table.
+  enum finding_kind {
+    FOUND_MISSING_WRITES,  // where: the undeclared region
+    FOUND_MISSING_READS,   // accessed without READS or WRITES
+    FOUND_WRONG_REGION,    // where: observed, declared: schedule.ccl
+    FOUND_NEEDS_SYNC,      // other: the routine that should sync
+    FOUND_NEEDLESS_SYNC,
+    FOUND_WRITE_EXTENT,    // where, rl, lo, hi: bounding box in global indices
+    FOUND_OBSERVED_WRITE,  // where: the observed region
+    // Only carry the clauses to process 0 for clause_file
+    FOUND_DECLARED_WRITE,  // where: schedule.ccl, declared: 1 if checked
+    FOUND_DECLARED_READ    // where: schedule.ccl
+  };
+
+  struct finding {
+    uint64_t routine, other;
+    int32_t kind, vi, tl, where, declared, rl;
+    int32_t lo[3], hi[3];
+    int32_t nranks, first_rank, first_iteration;
+  };
+
+  uint64_t name_hash(const std::string& name);
+
+  // Record a finding of this process; the counts are filled in here.
+  // Returns whether it was not recorded before. Extents that differ only
+  // in their box are merged into one that covers both.
+  bool add_finding(finding f,const std::string& routine,const std::string& other);
+
+  // Collective: merge the findings of all processes. On process 0 the
+  // result is returned sorted, elsewhere it is empty.
+  void reduce_findings(std::vector<finding>& all,std::map<uint64_t,std::string>& names);
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <cctk.h>
+#include <cctk_Parameters.h>
+#include <cctk_Functions.h>
+
+#include "Sampling.hh"
+
+namespace Read_Write_Diagnostics {
+
+  extern "C" int GetRefinementLevel(const cGH*);
+
+  namespace {
+    struct sample_state {
+      long calls;             // invocations seen
+      long checks;            // invocations checked
+      long next;              // invocation to check next
+      long interval;          // distance between checks
+      unsigned long grid;     // grid shape at the last invocation
+      sample_state() : calls(0), checks(0), next(0), interval(1), grid(0) {}
+    };
+
+    struct sample_key {
+      int rl, map, component;
+      bool operator<(const sample_key& b) const {
+        if(rl != b.rl) return rl < b.rl;
+        else if(map != b.map) return map < b.map;
+        else return component < b.component;
+      }
+    };
+
+    // routine id -> state
+    std::vector<std::map<sample_key,sample_state> > states;
+    sample_state *current = 0;
+
+    // Time spent in the hooks, and since the first hook was called
+    double hook_seconds = 0;
+    double first_hook = -1;
+
+    double wall_time() {
+      using namespace std::chrono;
+      return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    unsigned long grid_signature(const cGH *cctkGH) {
+      unsigned long h = 14695981039346656037UL;
+      for(int d=0;d<3;d++) {
+        const int v[3] = {cctkGH->cctk_lsh[d],cctkGH->cctk_lbnd[d],cctkGH->cctk_ash[d]};
+        for(int n=0;n<3;n++)
+          h = (h ^ (unsigned long)(unsigned)v[n]) * 1099511628211UL;
+      }
+      return h;
+    }
+  }
+
+  double hook_clock() {
+    return wall_time();
+  }
+
+  hook_timer::hook_timer() : start(wall_time()) {
+    if(first_hook < 0)
+      first_hook = start;
+  }
+
+  hook_timer::~hook_timer() {
+    hook_seconds += wall_time() - start;
+  }
+
+  bool sampling_should_check(int rid,const cGH *cctkGH) {
+    DECLARE_CCTK_PARAMETERS;
+    current = 0;
+    if(!sampling)
+      return true;
+    static const bool has_component = CCTK_IsFunctionAliased("GetLocalComponent");
+    const int component = has_component ? GetLocalComponent(cctkGH) : 0;
+    sample_key key{GetRefinementLevel(cctkGH),GetMap(cctkGH),component};
+    if(int(states.size()) <= rid)
+      states.resize(rid+1);
+    sample_state& st = states[rid][key];
+    const long call = st.calls++;
+    // Re-arm after a regrid
+    const unsigned long grid = grid_signature(cctkGH);
+    if(grid != st.grid) {
+      st.grid = grid;
+      st.checks = 0;
+      st.next = call;
+      st.interval = 1;
+    }
+    if(call < st.next)
+      return false;
+    if(st.checks >= sampling_initial_checks) {
+      const double elapsed = wall_time() - first_hook;
+      if(elapsed > 0 && hook_seconds > 0.01*sampling_overhead_budget*elapsed) {
+        // Over budget, try again next time
+        st.next = call+1;
+        return false;
+      }
+    }
+    current = &st;
+    st.checks++;
+    st.next = call+1;
+    return true;
+  }
+
+  void sampling_checked(bool new_writes) {
+    DECLARE_CCTK_PARAMETERS;
+    if(current == 0)
+      return;
+    sample_state& st = *current;
+    if(new_writes)
+      st.interval = 1;
+    else if(st.checks >= sampling_initial_checks)
+      st.interval = std::min(2*st.interval,long(sampling_max_interval));
+    st.next = st.calls-1 + st.interval;
+    current = 0;
+  }
+}
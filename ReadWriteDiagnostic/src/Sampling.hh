@@ -0,0 +1,32 @@
+#ifndef RDWR_SAMPLING_HH
+#define RDWR_SAMPLING_HH
+
+#include <cctk.h>
+
+namespace Read_Write_Diagnostics {
+
+  // Adaptive sampling of the routines to check. Every routine is
+  // checked on its first sampling_initial_checks invocations on each
+  // (refinement level, map, component). Afterwards the distance between
+  // checks doubles every time a check finds no new writes, up to
+  // sampling_max_interval. A new write, or a change of the grid shape,
+  // re-arms the routine.
+
+  // Whether to check the current invocation of routine id rid
+  bool sampling_should_check(int rid,const cGH *cctkGH);
+
+  // Result of the check decided by the last sampling_should_check()
+  void sampling_checked(bool new_writes);
+
+  // The clock of hook_timer, in seconds
+  double hook_clock();
+
+  // Measures the time spent in a hook, for the overhead budget
+  struct hook_timer {
+    double start;
+    hook_timer();
+    ~hook_timer();
+  };
+}
+
+#endif
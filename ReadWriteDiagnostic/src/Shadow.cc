@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <cctk.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Shadow.hh"
+
+namespace Read_Write_Diagnostics {
+
+  namespace {
+    // Chunks are at least this large, so that small grid functions
+    // share them
+    const size_t chunk_points = size_t(1) << 21;
+
+    struct chunk {
+      std::unique_ptr<CCTK_REAL[]> data;
+      size_t size, used;
+    };
+    std::vector<chunk> chunks;
+    size_t current = 0;    // the chunk to allocate from
+    size_t allocated = 0;  // points in all chunks
+
+    // Number of points that differ in [b,e), and the first and last one
+    inline long diff_span(const uint64_t *before,const uint64_t *after,
+                          ptrdiff_t b,ptrdiff_t e,ptrdiff_t& first,ptrdiff_t& last) {
+      long n = 0;
+      for(ptrdiff_t i=b;i<e;i++)
+        n += before[i] != after[i];
+      if(n == 0)
+        return 0;
+      first = b;
+      while(before[first] == after[first])
+        first++;
+      last = e-1;
+      while(before[last] == after[last])
+        last--;
+      return n;
+    }
+  }
+
+  void shadow_reset() {
+    for(size_t n=0;n<chunks.size();n++)
+      chunks[n].used = 0;
+    current = 0;
+  }
+
+  const CCTK_REAL *shadow_snapshot(const CCTK_REAL *data,size_t npoints,size_t budget) {
+    while(current < chunks.size() && chunks[current].size - chunks[current].used < npoints)
+      current++;
+    if(current == chunks.size()) {
+      // Empty chunks too small for npoints, e.g. sized for the grid
+      // functions before a regrid, would only hold budget
+      size_t kept = 0;
+      for(size_t n=0;n<chunks.size();n++) {
+        if(chunks[n].used == 0 && chunks[n].size < npoints)
+          allocated -= chunks[n].size;
+        else
+          chunks[kept++] = std::move(chunks[n]);
+      }
+      chunks.resize(kept);
+      current = kept;
+      const size_t max_points = budget / sizeof(CCTK_REAL);
+      if(allocated + npoints > max_points)
+        return 0;
+      const size_t size = std::min(std::max(npoints,chunk_points),max_points-allocated);
+      chunks.push_back(chunk{std::unique_ptr<CCTK_REAL[]>(new CCTK_REAL[size]),size,0});
+      allocated += size;
+    }
+    chunk& c = chunks[current];
+    CCTK_REAL *copy = c.data.get() + c.used;
+    c.used += npoints;
+    memcpy(copy,data,npoints*sizeof(CCTK_REAL));
+    return copy;
+  }
+
+  bool shadow_compare(const cGH *cctkGH,const CCTK_REAL *before,const CCTK_REAL *after,
+                      int nthreads,shadow_diff& diff) {
+    const int *cctk_nghostzones = cctkGH->cctk_nghostzones;
+    const int *cctk_lsh = cctkGH->cctk_lsh;
+    const uint64_t *b64 = (const uint64_t *)before;
+    const uint64_t *a64 = (const uint64_t *)after;
+    const int i0 = std::min(cctk_nghostzones[0],cctk_lsh[0]);
+    const int i1 = std::max(i0,cctk_lsh[0]-cctk_nghostzones[0]);
+    const size_t row_bytes = cctk_lsh[0]*sizeof(CCTK_REAL);
+    long count[27] = {0};
+    int lo[3] = {cctk_lsh[0],cctk_lsh[1],cctk_lsh[2]}, hi[3] = {-1,-1,-1};
+#ifdef _OPENMP
+    if(nthreads <= 0)
+      nthreads = omp_get_max_threads();
+#else
+    nthreads = 1;
+#endif
+#pragma omp parallel for schedule(static) num_threads(nthreads) if(nthreads > 1) \
+    reduction(+:count[:27]) reduction(min:lo[:3]) reduction(max:hi[:3])
+    for(int k=0;k<cctk_lsh[2];k++) {
+      const int kz = region_of(k,cctk_nghostzones[2],cctk_lsh[2]);
+      for(int j=0;j<cctk_lsh[1];j++) {
+        const ptrdiff_t cc = CCTK_GFINDEX3D(cctkGH,0,j,k);
+        if(memcmp(b64+cc,a64+cc,row_bytes) == 0)
+          continue;
+        const int jy = region_of(j,cctk_nghostzones[1],cctk_lsh[1]);
+        const int b[4] = {0,i0,i1,cctk_lsh[0]};
+        for(int ix=0;ix<3;ix++) {
+          ptrdiff_t first, last;
+          const long n = diff_span(b64,a64,cc+b[ix],cc+b[ix+1],first,last);
+          if(n == 0)
+            continue;
+          count[block_index(ix,jy,kz)] += n;
+          lo[0] = std::min(lo[0],int(first-cc));
+          hi[0] = std::max(hi[0],int(last-cc));
+          lo[1] = std::min(lo[1],j);
+          hi[1] = std::max(hi[1],j);
+          lo[2] = std::min(lo[2],k);
+          hi[2] = std::max(hi[2],k);
+        }
+      }
+    }
+    bool changed[27];
+    diff.total = 0;
+    for(int n=0;n<27;n++) {
+      diff.count[n] = count[n];
+      diff.total += count[n];
+      changed[n] = count[n] > 0;
+    }
+    if(diff.total == 0)
+      return false;
+    for(int d=0;d<3;d++) {
+      diff.ext.lo[d] = lo[d];
+      diff.ext.hi[d] = hi[d];
+    }
+    diff.ext.where = classify_blocks(cctkGH,changed);
+    return true;
+  }
+}
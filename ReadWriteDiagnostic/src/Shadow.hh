@@ -0,0 +1,35 @@
+#ifndef RDWR_SHADOW_HH
+#define RDWR_SHADOW_HH
+
+#include <cctk.h>
+#include <stddef.h>
+#include "Checksum.hh"
+
+namespace Read_Write_Diagnostics {
+
+  // Exact write detection: the checked grid functions are copied into a
+  // pooled arena before the routine and compared bit by bit afterwards.
+  // The arena keeps its chunks across calls, so in a steady state no
+  // memory is allocated, and never grows beyond the budget. Empty chunks
+  // too small for a request are released.
+
+  // Release all snapshots, at the start of a routine
+  void shadow_reset();
+
+  // Copy npoints values, or return 0 if the arena would exceed budget bytes
+  const CCTK_REAL *shadow_snapshot(const CCTK_REAL *data,size_t npoints,size_t budget);
+
+  struct shadow_diff {
+    long count[27];    // written points per block, see block_index()
+    long total;
+    write_extent ext;  // bounding box and region of the written points
+  };
+
+  // Compare a grid function to its snapshot, in parallel over k-planes.
+  // nthreads <= 0 means use the OpenMP default. Returns false if
+  // nothing was written.
+  bool shadow_compare(const cGH *cctkGH,const CCTK_REAL *before,const CCTK_REAL *after,
+                      int nthreads,shadow_diff& diff);
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cctk.h>
+
+#include "PreSync.h"
+#include "SoftDirty.hh"
+
+namespace Read_Write_Diagnostics {
+
+  namespace {
+    const uint64_t PM_SOFT_DIRTY = uint64_t(1) << 55;
+    int clear_fd = -1, pagemap_fd = -1;
+    long page_size = 0;
+    std::vector<uint64_t> pagemap;
+
+    bool read_pagemap(uintptr_t first,uintptr_t npages) {
+      pagemap.resize(npages);
+      const size_t len = npages*sizeof(uint64_t);
+      return pread(pagemap_fd,pagemap.data(),len,first*sizeof(uint64_t)) == ssize_t(len);
+    }
+
+    // Region of the points with linear indices in [a,b)
+    int classify(const cGH *cctkGH,ptrdiff_t a,ptrdiff_t b) {
+      const int *cctk_nghostzones = cctkGH->cctk_nghostzones;
+      const int *cctk_lsh = cctkGH->cctk_lsh;
+      const int *cctk_ash = cctkGH->cctk_ash;
+      const int i0 = std::min(cctk_nghostzones[0],cctk_lsh[0]);
+      const int i1 = std::max(i0,cctk_lsh[0]-cctk_nghostzones[0]);
+      int where = 0;
+      for(ptrdiff_t cc=a;cc<b;) {
+        const int i = cc % cctk_ash[0];
+        const int j = (cc / cctk_ash[0]) % cctk_ash[1];
+        const int k = cc / (ptrdiff_t(cctk_ash[0])*cctk_ash[1]);
+        // The part [i,ie) of this row that lies in [a,b)
+        const int ie = std::min(ptrdiff_t(cctk_ash[0]),i+(b-cc));
+        cc += ie-i;
+        if(j >= cctk_lsh[1] || k >= cctk_lsh[2])
+          continue;
+        const int ib = std::min(ie,cctk_lsh[0]);
+        if(i >= ib)
+          continue;
+        const bool inz = (cctk_nghostzones[2] <= k && k < cctk_lsh[2]-cctk_nghostzones[2]);
+        const bool iny = (cctk_nghostzones[1] <= j && j < cctk_lsh[1]-cctk_nghostzones[1]);
+        if(iny && inz) {
+          if(i < i1 && ib > i0)
+            where |= WH_INTERIOR;
+          if(i < i0 || ib > i1)
+            where |= WH_EXTERIOR;
+        } else {
+          where |= WH_EXTERIOR;
+        }
+        if(where == (WH_INTERIOR|WH_EXTERIOR))
+          break;
+      }
+      return where;
+    }
+  }
+
+  bool softdirty_clear() {
+    return clear_fd >= 0 && write(clear_fd,"4",1) == 1;
+  }
+
+  bool softdirty_available() {
+    static int available = -1;
+    if(available >= 0)
+      return available;
+    available = 0;
+    page_size = sysconf(_SC_PAGESIZE);
+    clear_fd = open("/proc/self/clear_refs",O_WRONLY);
+    pagemap_fd = open("/proc/self/pagemap",O_RDONLY);
+    if(clear_fd < 0 || pagemap_fd < 0)
+      return false;
+    // The kernel may be built without CONFIG_MEM_SOFT_DIRTY, in which
+    // case clearing succeeds but the bit is never set. Try it out.
+    void *probe = mmap(0,page_size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+    if(probe == MAP_FAILED)
+      return false;
+    volatile char *p = (volatile char *)probe;
+    const uintptr_t page = uintptr_t(probe) / page_size;
+    p[0] = 1;
+    if(softdirty_clear() && read_pagemap(page,1) && (pagemap[0] & PM_SOFT_DIRTY) == 0) {
+      p[0] = 2;
+      if(read_pagemap(page,1) && (pagemap[0] & PM_SOFT_DIRTY) != 0)
+        available = 1;
+    }
+    munmap(probe,page_size);
+    return available;
+  }
+
+  int softdirty_written(const cGH *cctkGH,const void *data) {
+    const ptrdiff_t npoints = ptrdiff_t(cctkGH->cctk_ash[0])*cctkGH->cctk_ash[1]*cctkGH->cctk_ash[2];
+    const uintptr_t addr = uintptr_t(data);
+    const uintptr_t end = addr + npoints*sizeof(CCTK_REAL);
+    const uintptr_t first = addr / page_size;
+    const uintptr_t last = (end - 1) / page_size;
+    if(!read_pagemap(first,last-first+1))
+      return -1;
+    int where = 0;
+    for(uintptr_t p=first;p<=last;p++) {
+      if((pagemap[p-first] & PM_SOFT_DIRTY) == 0)
+        continue;
+      // Points that start on this page
+      const uintptr_t pb = std::max(addr,p*page_size);
+      const uintptr_t pe = std::min(end,(p+1)*page_size);
+      const ptrdiff_t a = (pb - addr + sizeof(CCTK_REAL) - 1) / sizeof(CCTK_REAL);
+      const ptrdiff_t b = (pe - addr + sizeof(CCTK_REAL) - 1) / sizeof(CCTK_REAL);
+      const int page_where = classify(cctkGH,a,b);
+      if(page_where == (WH_INTERIOR|WH_EXTERIOR))
+        return where | SOFTDIRTY_MIXED;
+      where |= page_where;
+    }
+    return where;
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef RDWR_SOFTDIRTY_HH
+#define RDWR_SOFTDIRTY_HH
+
+#include <cctk.h>
+
+namespace Read_Write_Diagnostics {
+
+  // Write detection through the kernel's soft-dirty page bits, see
+  // Documentation/admin-guide/mm/soft-dirty.rst in the Linux sources.
+  // The granularity is one page, so points that share a page with a
+  // written point are reported as written as well. A page that holds
+  // both interior and exterior points does not tell which of them were
+  // written; the caller compares checksums for such variables.
+
+  // Check once whether soft-dirty tracking works on this host
+  bool softdirty_available();
+
+  // Clear the soft-dirty bits of all pages of the process
+  bool softdirty_clear();
+
+  // Set by softdirty_written() if a written page holds both interior
+  // and exterior points
+  const int SOFTDIRTY_MIXED = 0x100;
+
+  // The region (WH_INTERIOR and/or WH_EXTERIOR) of the points of the
+  // grid function at data that lie on pages written since the last
+  // softdirty_clear(), only counting pages entirely in one of them,
+  // plus SOFTDIRTY_MIXED. -1 if the page map could not be read.
+  int softdirty_written(const cGH *cctkGH,const void *data);
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <vector>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Trap.hh"
+
+namespace Read_Write_Diagnostics {
+
+  namespace {
+    struct trap_entry {
+      uintptr_t lo, hi; // protected pages, [lo,hi)
+      int slot;
+      bool operator<(const trap_entry& e) const { return lo < e.lo; }
+    };
+
+    // Sorted by address while armed. The handler only reads entries and
+    // sets hits, so nothing is allocated in signal context.
+    std::vector<trap_entry> entries;
+    std::vector<sig_atomic_t> hits;
+    volatile sig_atomic_t armed = 0;
+    struct sigaction previous;
+    uintptr_t page_size = 0;
+    bool installed = false;
+
+    void handler(int sig,siginfo_t *info,void *context) {
+      const uintptr_t addr = (uintptr_t)info->si_addr;
+      if(armed) {
+        size_t lo = 0, hi = entries.size();
+        while(lo < hi) {
+          const size_t mid = (lo+hi)/2;
+          if(entries[mid].hi <= addr)
+            lo = mid+1;
+          else
+            hi = mid;
+        }
+        if(lo < entries.size() && entries[lo].lo <= addr) {
+          const trap_entry& e = entries[lo];
+          mprotect((void *)e.lo,e.hi-e.lo,PROT_READ|PROT_WRITE);
+          ((volatile sig_atomic_t *)hits.data())[lo] = 1;
+          return;
+        }
+      }
+      // Not ours: pass it on, staying installed for the next trap
+      if((previous.sa_flags & SA_SIGINFO) != 0) {
+        previous.sa_sigaction(sig,info,context);
+      } else if(previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {
+        previous.sa_handler(sig);
+      } else {
+        // Delivered with the default action once the handler returns
+        signal(sig,SIG_DFL);
+        raise(sig);
+      }
+    }
+
+    // Apply prot to the entries, merging those on adjacent pages
+    void protect_all(int prot) {
+      for(size_t n=0;n<entries.size();) {
+        size_t m = n+1;
+        while(m < entries.size() && entries[m].lo == entries[m-1].hi)
+          m++;
+        mprotect((void *)entries[n].lo,entries[m-1].hi-entries[n].lo,prot);
+        n = m;
+      }
+    }
+  }
+
+  bool trap_install() {
+    if(installed)
+      return true;
+    page_size = sysconf(_SC_PAGESIZE);
+    struct sigaction action;
+    action.sa_sigaction = handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO;
+    installed = sigaction(SIGSEGV,&action,&previous) == 0;
+    return installed;
+  }
+
+  void trap_add(int slot,void *data,size_t bytes) {
+    const uintptr_t lo = ((uintptr_t)data + page_size-1) & ~(page_size-1);
+    const uintptr_t hi = ((uintptr_t)data + bytes) & ~(page_size-1);
+    if(lo < hi)
+      entries.push_back(trap_entry{lo,hi,slot});
+  }
+
+  void trap_arm() {
+    if(entries.empty())
+      return;
+    std::sort(entries.begin(),entries.end());
+    hits.assign(entries.size(),0);
+    armed = 1;
+    protect_all(PROT_NONE);
+  }
+
+  void trap_disarm(std::vector<int>& accessed) {
+    accessed.clear();
+    if(armed) {
+      protect_all(PROT_READ|PROT_WRITE);
+      armed = 0;
+      for(size_t n=0;n<entries.size();n++) {
+        if(hits[n])
+          accessed.push_back(entries[n].slot);
+      }
+    }
+    entries.clear();
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef RDWR_TRAP_HH
+#define RDWR_TRAP_HH
+
+#include <stddef.h>
+#include <vector>
+
+namespace Read_Write_Diagnostics {
+
+  // Detection of undeclared accesses through page protection. While a
+  // routine runs, the pages of the grid functions it does not declare
+  // are mapped PROT_NONE. The first access to one of them faults; the
+  // SIGSEGV handler records the variable, makes its pages accessible
+  // again and lets the routine continue. Only pages that lie entirely
+  // within a grid function are protected, so accesses to the partial
+  // pages at its ends are not seen.
+
+  // Install the SIGSEGV handler, once. Faults outside of protected
+  // pages are passed on to the previous handler.
+  bool trap_install();
+
+  // Add a variable to protect during the next call, identified by slot
+  void trap_add(int slot,void *data,size_t bytes);
+
+  // Protect all variables added since the last trap_disarm()
+  void trap_arm();
+
+  // Unprotect everything, and return the slots of the variables that
+  // were accessed
+  void trap_disarm(std::vector<int>& accessed);
+}
+
+#endif
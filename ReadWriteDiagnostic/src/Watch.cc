@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cctk.h>
+#include <cctk_Functions.h>
+
+#include "PreSync.h"
+#include "Log.hh"
+#include "Watch.hh"
+#include "rdwr_slab.h"
+
+namespace Read_Write_Diagnostics {
+
+  extern "C" int GetRefinementLevel(const cGH*);
+
+  namespace {
+    struct watch_var {
+      int vi, tl;
+      std::string name;
+    };
+
+    // The watch plan
+    std::vector<watch_var> vars;
+    int lo[3] = {0,0,0}, hi[3] = {0,0,0}; // local indices, inclusive
+    bool whole = false;                   // checksum whole variables
+    bool compiled = false;
+    FILE *dump = 0;
+    std::vector<bool> named;              // routines named in the dump
+    std::vector<double> slab;
+
+    void write_name(int tag,int id,const std::string& name) {
+      const rdwr_slab::name_header h{tag,id,int32_t(name.size())};
+      fwrite(&h,sizeof(h),1,dump);
+      fwrite(name.data(),1,name.size(),dump);
+    }
+
+    void close_dump() {
+      if(dump != 0)
+        fclose(dump);
+      dump = 0;
+    }
+
+    std::string valid_region(int vi,int tl) {
+      const int wh = Carpet_GetValidRegion(vi,tl);
+      std::string whs;
+      if((wh & WH_INTERIOR) != 0) whs += "I";
+      if((wh & WH_BOUNDARY) != 0) whs += "B";
+      if((wh & WH_GHOSTS) != 0) whs += "G";
+      return whs;
+    }
+  }
+
+  unsigned short internet_checksum(void const *restrict const addr,
+                                   size_t const len) {
+    unsigned long chk = 0;
+    ptrdiff_t const even = len & ~(size_t)1;
+#pragma omp parallel for reduction(+ : chk)
+    for (ptrdiff_t i = 0; i < even; i += 2) {
+      unsigned long const lb = ((unsigned char const *)addr)[i];
+      unsigned long const ub = ((unsigned char const *)addr)[i + 1];
+      chk += lb + (ub << 8);
+    }
+    if (len % 2) {
+      unsigned long const lb = ((unsigned char const *)addr)[len - 1];
+      chk += lb;
+    }
+    while (chk >> 16) {
+      chk = (chk & 0xffffUL) + (chk >> 16);
+    }
+    return ~chk;
+  }
+
+  void watch_compile() {
+    if(compiled)
+      return;
+    compiled = true;
+    const char *dbv = getenv("RDWR_DEBUG_VARS");
+    if(dbv == 0)
+      return;
+
+    std::istringstream ins{dbv};
+    std::string vname;
+    while(ins >> vname) {
+      int tl = 0;
+      while(vname.size() > 2 && vname.compare(vname.size()-2,2,"_p") == 0) {
+        tl += 1;
+        vname.erase(vname.size()-2);
+      }
+      const int vi = CCTK_VarIndex(vname.c_str());
+      if(vi < 0)
+        CCTK_VERROR("Unknown variable name: %s", vname.c_str());
+      // add the _p's back
+      for(int i = 0 ; i < tl ; ++i)
+        vname += "_p";
+      vars.push_back(watch_var{vi,tl,vname});
+    }
+
+    // x y z, separated by spaces or commas, each an index or a:b
+    const char *ixs = getenv("RDWR_DEBUG_INDEXES");
+    if(ixs != 0) {
+      std::string s(ixs);
+      std::replace(s.begin(),s.end(),',',' ');
+      std::istringstream cns{s};
+      std::string range;
+      for(int d=0;d<3 && cns >> range;d++) {
+        if(sscanf(range.c_str(),"%d:%d",&lo[d],&hi[d]) != 2)
+          hi[d] = lo[d] = atoi(range.c_str());
+        if(hi[d] < lo[d])
+          CCTK_VERROR("Empty range in RDWR_DEBUG_INDEXES: %s", range.c_str());
+      }
+      whole = lo[0] == -1 && lo[1] == -1 && lo[2] == -1 && hi[0] == -1 && hi[1] == -1 && hi[2] == -1;
+    }
+
+    const char *file = getenv("RDWR_DEBUG_DUMP");
+    if(file != 0 && !whole) {
+      char name[1024];
+      snprintf(name,sizeof(name),"%s.%d.bin",file,CCTK_MyProc(NULL));
+      dump = fopen(name,"wb");
+      if(dump == 0) {
+        CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot create %s",name);
+      } else {
+        fwrite(rdwr_slab::magic,1,sizeof(rdwr_slab::magic),dump);
+        for(size_t v=0;v<vars.size();v++)
+          write_name(rdwr_slab::SLAB_VAR,v,vars[v].name);
+        atexit(close_dump);
+      }
+    }
+  }
+
+  void watch_vars(const cGH *cctkGH,int rid,const std::string& routine,bool after) {
+    if(vars.empty())
+      return;
+    const int *lsh = cctkGH->cctk_lsh, *lbnd = cctkGH->cctk_lbnd;
+    // The part of the watch range on this process
+    int blo[3], bhi[3];
+    bool inside = true;
+    for(int d=0;d<3;d++) {
+      blo[d] = std::max(lo[d],0);
+      bhi[d] = std::min(hi[d],lsh[d]-1);
+      inside &= blo[d] <= bhi[d];
+    }
+    if(dump != 0 && rid >= 0 && (size_t(rid) >= named.size() || !named[rid])) {
+      if(size_t(rid) >= named.size())
+        named.resize(rid+1);
+      named[rid] = true;
+      write_name(rdwr_slab::SLAB_ROUTINE,rid,routine);
+    }
+    for(size_t v=0;v<vars.size();v++) {
+      const watch_var& w = vars[v];
+      const CCTK_REAL *ptr = (const CCTK_REAL*)CCTK_VarDataPtrI(cctkGH,w.tl,w.vi);
+      if(ptr == 0) {
+        if(dump == 0) {
+          RDWR_LOG(LOG_TRACE) << " RDWR:  " << w.name << " := ??? (" << valid_region(w.vi,w.tl) << ")";
+        }
+        continue;
+      }
+      if(whole) {
+        unsigned int cksum = internet_checksum(ptr, cctkGH->cctk_ash[0]*cctkGH->cctk_ash[1]*cctkGH->cctk_ash[2]*sizeof(CCTK_REAL));
+        RDWR_LOG(LOG_TRACE) << " RDWR:  " << w.name << " := " << cksum << " (" << valid_region(w.vi,w.tl) << ")";
+        continue;
+      }
+      if(!inside)
+        continue;
+      if(dump != 0) {
+        rdwr_slab::slab_header h;
+        h.tag = rdwr_slab::SLAB_DATA;
+        h.routine = rid;
+        h.after = after;
+        h.iteration = cctkGH->cctk_iteration;
+        h.rl = GetRefinementLevel(cctkGH);
+        h.var = v;
+        for(int d=0;d<3;d++) {
+          h.lo[d] = blo[d]+lbnd[d];
+          h.hi[d] = bhi[d]+lbnd[d];
+        }
+        slab.clear();
+        for(int k=blo[2];k<=bhi[2];k++)
+          for(int j=blo[1];j<=bhi[1];j++) {
+            const CCTK_REAL *row = ptr + CCTK_GFINDEX3D(cctkGH,0,j,k);
+            slab.insert(slab.end(),row+blo[0],row+bhi[0]+1);
+          }
+        fwrite(&h,sizeof(h),1,dump);
+        fwrite(slab.data(),sizeof(double),slab.size(),dump);
+        continue;
+      }
+      const std::string whs = valid_region(w.vi,w.tl);
+      if(lo[0] == hi[0] && lo[1] == hi[1] && lo[2] == hi[2]) {
+        RDWR_LOG(LOG_TRACE) << " RDWR:  " << w.name << " := " << ptr[CCTK_GFINDEX3D(cctkGH,lo[0],lo[1],lo[2])] << " (" << whs << ")";
+        continue;
+      }
+      for(int k=blo[2];k<=bhi[2];k++)
+        for(int j=blo[1];j<=bhi[1];j++)
+          for(int i=blo[0];i<=bhi[0];i++) {
+            RDWR_LOG(LOG_TRACE) << " RDWR:  " << w.name << "(" << i << "," << j << "," << k << ") := "
+              << ptr[CCTK_GFINDEX3D(cctkGH,i,j,k)] << " (" << whs << ")";
+          }
+    }
+  }
+}
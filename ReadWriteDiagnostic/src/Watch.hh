@@ -0,0 +1,29 @@
+#ifndef RDWR_WATCH_HH
+#define RDWR_WATCH_HH
+
+#include <cctk.h>
+#include <string>
+
+namespace Read_Write_Diagnostics {
+
+  // Debug output before and after every routine, selected by the
+  // environment:
+  //   RDWR_DEBUG_VARS     variables to watch, with _p for past timelevels
+  //   RDWR_DEBUG_INDEXES  x y z, each an index or a range a:b; -1 -1 -1
+  //                       prints a checksum of the whole variable
+  //   RDWR_DEBUG_DUMP     write the watched slabs to <name>.<rank>.bin
+  //                       instead of logging them, see rdwr_slab.h
+  // The environment is parsed once into a watch plan.
+
+  void watch_compile();
+
+  // The 16 bit ones' complement sum of RFC 1071, printed for -1 -1 -1
+  unsigned short internet_checksum(void const *restrict const addr,
+                                   size_t const len);
+
+  // Log or dump the watched slabs at the start (after = false) or end
+  // of routine id rid
+  void watch_vars(const cGH *cctkGH,int rid,const std::string& routine,bool after);
+}
+
+#endif
@@ -8,4 +8,33 @@ extern
 #endif
 void *RDWR_VarDataPtrI(const cGH *,int,int);
 
+/* Access the current scheduled routine has to a variable, according to
+   its READS/WRITES clauses: a combination of the flags below, or 0. */
+#define RDWR_ACCESS_READ  1
+#define RDWR_ACCESS_WRITE 2
+extern
+#ifdef __cplusplus
+"C"
+#endif
+int RDWR_VarAccessI(const cGH *,int,int);
+
+/* What checking a routine has cost this process, the values filled in by
+   the aliased function RDWR_QueryOverhead(routine,values,nvalues) for
+   "thorn::routine", or for all routines together if routine is "".
+   Times are in seconds; wclause is part of post. varptr_calls and varptr,
+   the time in RDWR_VarDataPtrI estimated from every 64th call, are only
+   counted with overhead_varptr. */
+#define RDWR_OVERHEAD_CALLS        0
+#define RDWR_OVERHEAD_CHECKS       1  /* calls checked for writes */
+#define RDWR_OVERHEAD_PRE          2
+#define RDWR_OVERHEAD_POST         3
+#define RDWR_OVERHEAD_WCLAUSE      4
+#define RDWR_OVERHEAD_VARPTR_CALLS 5
+#define RDWR_OVERHEAD_VARPTR       6
+#define RDWR_OVERHEAD_BYTES        7  /* hashed or compared */
+#define RDWR_OVERHEAD_VARIABLES    8  /* checked, over all calls */
+#define RDWR_OVERHEAD_TIMELEVELS   9  /* past timelevels among them */
+#define RDWR_OVERHEAD_CACHE_HITS   10 /* reused checksums */
+#define RDWR_OVERHEAD_NVALUES      11
+
 #endif
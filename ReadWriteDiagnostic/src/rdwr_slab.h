@@ -0,0 +1,36 @@
+#ifndef RDWR_SLAB_H
+#define RDWR_SLAB_H
+
+// Slab dump files written with RDWR_DEBUG_DUMP, one per process. After
+// the 8 byte magic the file is a sequence of records, each starting with
+// an int32 tag:
+//
+//   SLAB_ROUTINE  id, length, name           names a routine id
+//   SLAB_VAR      id, length, name           names a watched variable
+//   SLAB_DATA     slab_header, then the points
+//
+// The points of a slab are doubles, x varying fastest, in the box
+// [lo,hi] (inclusive, global indices) of the part of the watch range on
+// this process. ReadWriteDiagnostic/util/slabdump.cc reads these files.
+
+#include <stdint.h>
+
+namespace rdwr_slab {
+
+  const char magic[8] = {'R','D','W','R','S','L','B','1'};
+
+  enum { SLAB_ROUTINE = 1, SLAB_VAR = 2, SLAB_DATA = 3 };
+
+  struct name_header {
+    int32_t tag, id, length;
+  };
+
+  struct slab_header {
+    int32_t tag;
+    int32_t routine, after;  // after is 0 before the routine, 1 after it
+    int32_t iteration, rl, var;
+    int32_t lo[3], hi[3];
+  };
+}
+
+#endif
@@ -0,0 +1,153 @@
+// Print the slab dumps written by ReadWriteDiagnostic with RDWR_DEBUG_DUMP
+//
+//   c++ -O2 -o slabdump slabdump.cc
+//   ./slabdump [options] dump.<rank>.bin ...
+//
+// Options select the slabs to print:
+//   -v NAME      only this variable (as in RDWR_DEBUG_VARS)
+//   -r TEXT      only routines whose thorn::routine contains TEXT
+//   -i FROM:TO   only iterations FROM to TO, either may be omitted
+//   -c           only slabs that differ from the previous one of the
+//                same variable and box
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/rdwr_slab.h"
+
+namespace {
+
+  struct filter_t {
+    std::string var, routine;
+    long from = -1, to = -1;
+    bool changed = false;
+  };
+
+  bool dump(const char *file,const filter_t& filter) {
+    using namespace rdwr_slab;
+    std::ifstream in(file,std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+    if(data.size() < sizeof(magic) || memcmp(data.data(),magic,sizeof(magic)) != 0) {
+      std::cerr << file << ": not a slab dump" << std::endl;
+      return false;
+    }
+    const char *p = data.data()+sizeof(magic), *end = data.data()+data.size();
+    std::map<int,std::string> routines, vars;
+    std::map<std::vector<int32_t>,std::vector<double> > last;
+    while(p < end) {
+      int32_t tag;
+      if(end-p < ptrdiff_t(sizeof(tag)))
+        break;
+      memcpy(&tag,p,sizeof(tag));
+      if(tag == SLAB_ROUTINE || tag == SLAB_VAR) {
+        name_header h;
+        if(end-p < ptrdiff_t(sizeof(h)))
+          break;
+        memcpy(&h,p,sizeof(h));
+        p += sizeof(h);
+        if(h.length < 0 || end-p < h.length)
+          break;
+        (tag == SLAB_ROUTINE ? routines : vars)[h.id].assign(p,h.length);
+        p += h.length;
+        continue;
+      }
+      if(tag != SLAB_DATA)
+        break;
+      slab_header h;
+      if(end-p < ptrdiff_t(sizeof(h)))
+        break;
+      memcpy(&h,p,sizeof(h));
+      p += sizeof(h);
+      long n = 1;
+      for(int d=0;d<3;d++)
+        n *= h.hi[d]-h.lo[d]+1;
+      if(n <= 0 || end-p < ptrdiff_t(n*sizeof(double)))
+        break;
+      std::vector<double> values(n);
+      memcpy(values.data(),p,n*sizeof(double));
+      p += n*sizeof(double);
+      const std::string& var = vars[h.var];
+      const std::string& routine = routines[h.routine];
+      if(!filter.var.empty() && var != filter.var)
+        continue;
+      if(!filter.routine.empty() && routine.find(filter.routine) == std::string::npos)
+        continue;
+      if((filter.from >= 0 && h.iteration < filter.from) || (filter.to >= 0 && h.iteration > filter.to))
+        continue;
+      if(filter.changed) {
+        const std::vector<int32_t> key = {h.var,h.rl,h.lo[0],h.lo[1],h.lo[2],h.hi[0],h.hi[1],h.hi[2]};
+        std::vector<double>& prev = last[key];
+        const bool same = prev.size() == values.size() && memcmp(prev.data(),values.data(),n*sizeof(double)) == 0;
+        prev.swap(values);
+        if(same)
+          continue;
+        values = prev;
+      }
+      printf("it=%d %s %s rl=%d %s i=[%d,%d] j=[%d,%d] k=[%d,%d]\n",h.iteration,h.after ? "AFTER" : "BEFORE",
+        routine.c_str(),h.rl,var.c_str(),h.lo[0],h.hi[0],h.lo[1],h.hi[1],h.lo[2],h.hi[2]);
+      long m = 0;
+      for(int k=h.lo[2];k<=h.hi[2];k++)
+        for(int j=h.lo[1];j<=h.hi[1];j++) {
+          printf("  j=%d k=%d:",j,k);
+          for(int i=h.lo[0];i<=h.hi[0];i++)
+            printf(" %.17g",values[m++]);
+          printf("\n");
+        }
+    }
+    if(p != end) {
+      std::cerr << file << ": corrupt record at offset " << (p - data.data()) << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+int main(int argc,char **argv) {
+  filter_t filter;
+  int n = 1;
+  for(;n < argc && argv[n][0] == '-';n++) {
+    const std::string opt = argv[n];
+    if(opt == "-c") {
+      filter.changed = true;
+      continue;
+    }
+    if(n+1 >= argc) {
+      std::cerr << "missing argument for " << opt << std::endl;
+      return 1;
+    }
+    const std::string arg = argv[++n];
+    if(opt == "-v") {
+      filter.var = arg;
+    } else if(opt == "-r") {
+      filter.routine = arg;
+    } else if(opt == "-i") {
+      const size_t colon = arg.find(':');
+      if(colon == std::string::npos) {
+        filter.from = filter.to = atol(arg.c_str());
+      } else {
+        if(colon > 0)
+          filter.from = atol(arg.substr(0,colon).c_str());
+        if(colon+1 < arg.size())
+          filter.to = atol(arg.substr(colon+1).c_str());
+      }
+    } else {
+      std::cerr << "unknown option " << opt << std::endl;
+      return 1;
+    }
+  }
+  if(n >= argc) {
+    std::cerr << "usage: " << argv[0] << " [-v var] [-r routine] [-i from:to] [-c] file.bin ..." << std::endl;
+    return 1;
+  }
+  bool ok = true;
+  for(;n < argc;n++)
+    ok &= dump(argv[n],filter);
+  return ok ? 0 : 1;
+}
@@ -1,68 +1,273 @@
 #include <cctk.h>
 #include <cctk_Schedule.h>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 #include <cctk_Parameters.h>
+#include <cctk_Functions.h>
+#include <cctype>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+#include "trace_history.h"
 
 namespace trace {
-  int trace_vindex = -5;
-  CCTK_REAL trace_old_value = 0;
-  CCTK_REAL trace_new_value = 0;
 
-  void fetch_var(const cGH *cctkGH) {
-    trace_old_value = trace_new_value;
-    if(cctkGH == 0)
-      return;
+  // A watched variable: trace_varname lists them, with a _p per past
+  // timelevel as in READS/WRITES clauses.
+  struct watch_var {
+    int vi, tl;
+    std::string name;
+  };
+
+  struct watch_point {
+    int x, y, z;
+  };
+
+  // Every variable is watched at every point. The values are stored
+  // variable-major: value[v*points.size()+p].
+  std::vector<watch_var> vars;
+  std::vector<watch_point> points;
+  std::vector<CCTK_REAL> old_values, new_values;
+
+  // Linear index of every point on the current grid, -1 if outside
+  std::vector<ptrdiff_t> indices;
+  int grid[6] = {-1,-1,-1,-1,-1,-1}; // lsh, ash of the indices
+
+  void parse_watch_list() {
     DECLARE_CCTK_PARAMETERS;
-    if(trace_vindex == -5) {
-      trace_vindex = CCTK_VarIndex(trace_varname);
-      if(trace_vindex < 0) {
-        std::cerr << "trace_vindex=" << trace_vindex << "\n";
-        abort();
+    std::istringstream names(trace_varname);
+    std::string name;
+    while(names >> name) {
+      int tl = 0;
+      while(name.size() > 2 && name.compare(name.size()-2,2,"_p") == 0 && CCTK_VarIndex(name.c_str()) < 0) {
+        name.erase(name.size()-2);
+        tl++;
       }
+      const int vi = CCTK_VarIndex(name.c_str());
+      if(vi < 0)
+        CCTK_VERROR("Unknown variable in trace_varname: %s",name.c_str());
+      for(int i=0;i<tl;i++)
+        name += "_p";
+      vars.push_back(watch_var{vi,tl,name});
+    }
+
+    // All integers in trace_points, in groups of three
+    std::string pts(trace_points);
+    for(auto c=pts.begin();c != pts.end();++c) {
+      if(*c != '-' && !isdigit(*c))
+        *c = ' ';
     }
-    if(trace_vindex >= 0) {
-      CCTK_REAL *gf = (CCTK_REAL*)CCTK_VarDataPtrI(cctkGH,0,trace_vindex);
-      if(gf != 0) {
-        assert(trace_xcoord >= 0 && trace_xcoord < cctkGH->cctk_lsh[0]);
-        assert(trace_ycoord >= 0 && trace_ycoord < cctkGH->cctk_lsh[1]);
-        assert(trace_zcoord >= 0 && trace_zcoord < cctkGH->cctk_lsh[2]);
-        int index = CCTK_GFINDEX3D(cctkGH,trace_xcoord,trace_ycoord,trace_zcoord);
-        trace_new_value = gf[index];
+    std::istringstream coords(pts);
+    std::vector<int> xyz;
+    int n;
+    while(coords >> n)
+      xyz.push_back(n);
+    if(!coords.eof() || xyz.size() % 3 != 0)
+      CCTK_VERROR("trace_points must be a list of x,y,z triples: %s",trace_points);
+    for(size_t i=0;i<xyz.size();i+=3)
+      points.push_back(watch_point{xyz[i],xyz[i+1],xyz[i+2]});
+    if(points.empty())
+      points.push_back(watch_point{int(trace_xcoord),int(trace_ycoord),int(trace_zcoord)});
+
+    old_values.assign(vars.size()*points.size(),0);
+    new_values.assign(vars.size()*points.size(),0);
+  }
+
+  void update_indices(const cGH *cctkGH) {
+    const int *lsh = cctkGH->cctk_lsh, *ash = cctkGH->cctk_ash;
+    if(memcmp(grid,lsh,3*sizeof(int)) == 0 && memcmp(grid+3,ash,3*sizeof(int)) == 0)
+      return;
+    memcpy(grid,lsh,3*sizeof(int));
+    memcpy(grid+3,ash,3*sizeof(int));
+    indices.resize(points.size());
+    for(size_t p=0;p<points.size();p++) {
+      const watch_point& pt = points[p];
+      const bool inside = pt.x >= 0 && pt.x < lsh[0] && pt.y >= 0 && pt.y < lsh[1] && pt.z >= 0 && pt.z < lsh[2];
+      indices[p] = inside ? CCTK_GFINDEX3D(cctkGH,pt.x,pt.y,pt.z) : -1;
+    }
+  }
+
+  // Gather all watched values. Values that are not available keep
+  // their last value, so they do not show up as changes.
+  void fetch_vars(const cGH *cctkGH) {
+    old_values.swap(new_values);
+    new_values = old_values;
+    if(cctkGH == 0)
+      return;
+    update_indices(cctkGH);
+    const size_t np = points.size();
+    for(size_t v=0;v<vars.size();v++) {
+      const CCTK_REAL *gf = (const CCTK_REAL*)CCTK_VarDataPtrI(cctkGH,vars[v].tl,vars[v].vi);
+      if(gf == 0)
+        continue;
+      CCTK_REAL *values = &new_values[v*np];
+      for(size_t p=0;p<np;p++) {
+        if(indices[p] >= 0)
+          values[p] = gf[indices[p]];
       }
     }
   }
 
+  // The value history of this process, see trace_history.h
+  struct history_t {
+    FILE *file = 0;
+    size_t buffer_size = 0;
+    std::vector<uint8_t> buf;
+    int iteration = 0;
+    std::vector<CCTK_REAL> last;    // last new value of every watch
+    std::unordered_map<const cFunctionData *,int> routine_ids;
+    std::unordered_map<std::string,int> bin_ids;
+  };
+  history_t history;
+
+  void flush_history() {
+    if(history.file == 0)
+      return;
+    fwrite(history.buf.data(),1,history.buf.size(),history.file);
+    fflush(history.file);
+    history.buf.clear();
+  }
+
+  extern "C" void Trace_CloseHistory() {
+    if(history.file == 0)
+      return;
+    flush_history();
+    fclose(history.file);
+    history.file = 0;
+  }
+
+  void open_history() {
+    DECLARE_CCTK_PARAMETERS;
+    using namespace trace_history;
+    char name[1024];
+    snprintf(name,sizeof(name),"%s.%d.bin",history_file,CCTK_MyProc(NULL));
+    history.file = fopen(name,"wb");
+    if(history.file == 0) {
+      CCTK_VWarn(1,__LINE__,__FILE__,CCTK_THORNSTRING,"Cannot create %s",name);
+      return;
+    }
+    fwrite(magic,1,sizeof(magic),history.file);
+    history.buffer_size = history_buffer;
+    history.buf.reserve(history.buffer_size+1024);
+    history.last.assign(new_values.size(),0);
+    const size_t np = points.size();
+    for(size_t n=0;n<new_values.size();n++) {
+      const watch_point& pt = points[n%np];
+      history.buf.push_back(REC_WATCH);
+      put_varint(history.buf,n);
+      put_string(history.buf,vars[n/np].name);
+      put_varint(history.buf,zigzag(pt.x));
+      put_varint(history.buf,zigzag(pt.y));
+      put_varint(history.buf,zigzag(pt.z));
+    }
+    std::atexit(Trace_CloseHistory);
+  }
+
+  // Ids of the routine and its bin, named in the history on first use
+  std::pair<int,int> history_ids(const cFunctionData *attribute) {
+    using namespace trace_history;
+    int routine, bin;
+    auto r = history.routine_ids.find(attribute);
+    if(r != history.routine_ids.end()) {
+      routine = r->second;
+    } else {
+      routine = history.routine_ids.size();
+      history.routine_ids[attribute] = routine;
+      history.buf.push_back(REC_ROUTINE);
+      put_varint(history.buf,routine);
+      put_string(history.buf,std::string(attribute->thorn)+"::"+attribute->routine);
+    }
+    auto b = history.bin_ids.find(attribute->where);
+    if(b != history.bin_ids.end()) {
+      bin = b->second;
+    } else {
+      bin = history.bin_ids.size();
+      history.bin_ids[attribute->where] = bin;
+      history.buf.push_back(REC_BIN);
+      put_varint(history.buf,bin);
+      put_string(history.buf,attribute->where);
+    }
+    return std::make_pair(routine,bin);
+  }
+
+  void record_change(const cGH *cctkGH,bool inside,const cFunctionData *attribute,size_t n) {
+    using namespace trace_history;
+    const std::pair<int,int> ids = history_ids(attribute);
+    const CCTK_REAL old_value = old_values[n], new_value = new_values[n];
+    const bool has_old = memcmp(&old_value,&history.last[n],sizeof(CCTK_REAL)) != 0;
+    history.buf.push_back(REC_VALUE | (inside ? FLAG_INSIDE : 0) | (has_old ? FLAG_OLD : 0));
+    put_varint(history.buf,zigzag(int64_t(cctkGH->cctk_iteration) - history.iteration));
+    history.iteration = cctkGH->cctk_iteration;
+    put_varint(history.buf,ids.first);
+    put_varint(history.buf,ids.second);
+    put_varint(history.buf,n);
+    if(has_old)
+      put_double(history.buf,old_value,history.last[n]);
+    put_double(history.buf,new_value,old_value);
+    history.last[n] = new_value;
+    if(history.buf.size() >= history.buffer_size)
+      flush_history();
+  }
+
   bool cmp(CCTK_REAL r1,CCTK_REAL r2) {
     if(std::isnan(r1) and std::isnan(r2)) return true;
     return r1 == r2;
   }
 
+  void report_changes(const cGH *cctkGH,bool inside,const cFunctionData *attribute) {
+    DECLARE_CCTK_PARAMETERS;
+    const char *when = inside ? "INSIDE" : "BEFORE";
+    std::ostringstream msg;
+    const size_t np = points.size();
+    for(size_t n=0;n<new_values.size();n++) {
+      if(cmp(new_values[n],old_values[n]))
+        continue;
+      if(history.file != 0)
+        record_change(cctkGH,inside,attribute,n);
+      if(!trace_print)
+        continue;
+      const watch_var& v = vars[n/np];
+      const watch_point& pt = points[n%np];
+      msg << std::scientific << "VALUE CHANGED " << when << " " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where
+        << " " << v.name << "(" << pt.x << "," << pt.y << "," << pt.z << ")"
+        << " old value=" << old_values[n] << " new value=" << new_values[n] << "\n";
+    }
+    if(msg.tellp() > 0)
+      std::cout << msg.str();
+  }
+
   int pre_call(const void *arg1,void *arg2,void *arg3,void *arg4) {
     const cGH *cctkGH = (const cGH *)arg1;
     const cFunctionData *attribute = (const cFunctionData *)arg3;
     //std::cout << "/=== " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where << "\n";
-    fetch_var(cctkGH);
-    if(!cmp(trace_new_value,trace_old_value)) {
-      std::cout << std::scientific << "VALUE CHANGED BEFORE " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where
-        << " old value=" << trace_old_value << " new value=" << trace_new_value << "\n";
-    }
+    fetch_vars(cctkGH);
+    report_changes(cctkGH,false,attribute);
     return 0;
   }
 
   int post_call(const void *arg1,void *arg2,void *arg3,void *arg4) {
     const cGH *cctkGH = (const cGH *)arg1;
     const cFunctionData *attribute = (const cFunctionData *)arg3;
-    fetch_var(cctkGH);
-    if(!cmp(trace_new_value,trace_old_value)) {
-      std::cout << std::scientific << "VALUE CHANGED INSIDE " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where
-        << " old value=" << trace_old_value << " new value=" << trace_new_value << "\n";
-    }
+    fetch_vars(cctkGH);
+    report_changes(cctkGH,true,attribute);
     //std::cout << "\\=== " << attribute->thorn << "::" << attribute->routine << " in " << attribute->where << "\n";
     return 0;
   }
 
   extern "C" void Trace_AddDiagnosticCalls() {
+    DECLARE_CCTK_PARAMETERS;
+    parse_watch_list();
+    if(vars.empty()) {
+      CCTK_WARN(1,"trace_varname is empty, nothing to trace");
+      return;
+    }
+    if(trace_history)
+      open_history();
     RegisterScheduleWrapper(pre_call,post_call);
   }
 }
@@ -0,0 +1,104 @@
+#ifndef TRACE_HISTORY_H
+#define TRACE_HISTORY_H
+
+// Value history files written by Trace with trace_history = yes, one per
+// process. After the 8 byte magic the file is a sequence of records,
+// each starting with a tag byte:
+//
+//   REC_ROUTINE  id, name             names a routine id
+//   REC_BIN      id, name             names a schedule bin id
+//   REC_WATCH    id, name, x, y, z    a watched variable and point
+//   REC_VALUE    iteration delta, routine, bin, watch, [old], new
+//
+// Integers are LEB128 varints, signed ones zigzag encoded. A value is
+// stored as its XOR with a reference value, without the leading and
+// trailing zero bytes: new relative to old, and old relative to the
+// last new value of the same watch. old is only present (FLAG_OLD) when
+// it differs from that. FLAG_INSIDE marks changes inside a routine, as
+// opposed to before it. Trace/util/tracedump.cc reads these files.
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace trace_history {
+
+  const char magic[8] = {'T','R','A','C','E','H','1','\n'};
+
+  enum { REC_VALUE = 0, REC_ROUTINE = 1, REC_BIN = 2, REC_WATCH = 3 };
+  enum { FLAG_INSIDE = 0x10, FLAG_OLD = 0x20, TAG_MASK = 0x0f };
+
+  inline void put_varint(std::vector<uint8_t>& b,uint64_t v) {
+    while(v >= 0x80) {
+      b.push_back(uint8_t(v) | 0x80);
+      v >>= 7;
+    }
+    b.push_back(uint8_t(v));
+  }
+
+  inline bool get_varint(const uint8_t *&p,const uint8_t *end,uint64_t& v) {
+    v = 0;
+    for(int shift=0;p < end && shift < 64;shift+=7) {
+      const uint8_t c = *p++;
+      v |= uint64_t(c & 0x7f) << shift;
+      if((c & 0x80) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  inline uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+  inline int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+  // One byte with the number of leading (high nibble) and trailing zero
+  // bytes of the XOR, then the bytes in between, most significant first
+  inline void put_double(std::vector<uint8_t>& b,double v,double ref) {
+    uint64_t x, r;
+    memcpy(&x,&v,8);
+    memcpy(&r,&ref,8);
+    x ^= r;
+    int lead = 0, trail = 0;
+    while(lead < 8 && (x >> (56-8*lead) & 0xff) == 0)
+      lead++;
+    if(lead < 8) {
+      while((x >> (8*trail) & 0xff) == 0)
+        trail++;
+    }
+    b.push_back(uint8_t(lead << 4 | trail));
+    for(int i=7-lead;i>=trail;i--)
+      b.push_back(uint8_t(x >> (8*i)));
+  }
+
+  inline bool get_double(const uint8_t *&p,const uint8_t *end,double ref,double& v) {
+    if(p == end)
+      return false;
+    const int lead = *p >> 4, trail = *p & 0x0f;
+    p++;
+    if(lead > 8 || (lead < 8 && lead+trail > 7) || end-p < 8-lead-trail)
+      return false;
+    uint64_t x = 0, r;
+    for(int i=7-lead;i>=trail;i--)
+      x |= uint64_t(*p++) << (8*i);
+    memcpy(&r,&ref,8);
+    x ^= r;
+    memcpy(&v,&x,8);
+    return true;
+  }
+
+  inline void put_string(std::vector<uint8_t>& b,const std::string& s) {
+    put_varint(b,s.size());
+    b.insert(b.end(),s.begin(),s.end());
+  }
+
+  inline bool get_string(const uint8_t *&p,const uint8_t *end,std::string& s) {
+    uint64_t n;
+    if(!get_varint(p,end,n) || uint64_t(end-p) < n)
+      return false;
+    s.assign((const char *)p,n);
+    p += n;
+    return true;
+  }
+}
+
+#endif
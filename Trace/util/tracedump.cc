@@ -0,0 +1,148 @@
+// Print the value history files written by Trace (trace_history = yes)
+//
+//   c++ -O2 -o tracedump tracedump.cc
+//   ./tracedump [options] trace_history.<rank>.bin ...
+//
+// Options select the changes to print:
+//   -v NAME      only this variable (as in trace_varname, e.g. ADMBASE::gxx_p)
+//   -r TEXT      only routines whose thorn::routine contains TEXT
+//   -p X,Y,Z     only this point
+//   -i FROM:TO   only iterations FROM to TO, either may be omitted
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/trace_history.h"
+
+namespace {
+
+  struct watch_t {
+    std::string name;
+    int x, y, z;
+  };
+
+  struct filter_t {
+    std::string var, routine;
+    bool point = false;
+    int x = 0, y = 0, z = 0;
+    long from = -1, to = -1;
+  };
+
+  bool dump(const char *file,const filter_t& filter) {
+    using namespace trace_history;
+    std::ifstream in(file,std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+    if(data.size() < sizeof(magic) || memcmp(data.data(),magic,sizeof(magic)) != 0) {
+      std::cerr << file << ": not a Trace history file" << std::endl;
+      return false;
+    }
+    const uint8_t *p = data.data()+sizeof(magic), *end = data.data()+data.size();
+    std::map<uint64_t,std::string> routines, bins;
+    std::map<uint64_t,watch_t> watches;
+    std::map<uint64_t,double> last;
+    int64_t iteration = 0;
+    while(p < end) {
+      const uint8_t tag = *p++;
+      uint64_t id, a, b, c;
+      std::string name;
+      bool ok = true;
+      switch(tag & TAG_MASK) {
+      case REC_ROUTINE:
+        ok = get_varint(p,end,id) && get_string(p,end,routines[id]);
+        break;
+      case REC_BIN:
+        ok = get_varint(p,end,id) && get_string(p,end,bins[id]);
+        break;
+      case REC_WATCH:
+        ok = get_varint(p,end,id) && get_string(p,end,name) &&
+          get_varint(p,end,a) && get_varint(p,end,b) && get_varint(p,end,c);
+        if(ok)
+          watches[id] = watch_t{name,int(unzigzag(a)),int(unzigzag(b)),int(unzigzag(c))};
+        break;
+      case REC_VALUE: {
+        uint64_t delta, routine, bin, watch;
+        ok = get_varint(p,end,delta) && get_varint(p,end,routine) &&
+          get_varint(p,end,bin) && get_varint(p,end,watch);
+        if(!ok)
+          break;
+        iteration += unzigzag(delta);
+        double old_value = last[watch], new_value;
+        if((tag & FLAG_OLD) != 0)
+          ok = get_double(p,end,last[watch],old_value);
+        ok = ok && get_double(p,end,old_value,new_value);
+        if(!ok)
+          break;
+        last[watch] = new_value;
+        const watch_t& w = watches[watch];
+        const std::string& rname = routines[routine];
+        if(!filter.var.empty() && w.name != filter.var)
+          break;
+        if(!filter.routine.empty() && rname.find(filter.routine) == std::string::npos)
+          break;
+        if(filter.point && (w.x != filter.x || w.y != filter.y || w.z != filter.z))
+          break;
+        if((filter.from >= 0 && iteration < filter.from) || (filter.to >= 0 && iteration > filter.to))
+          break;
+        printf("it=%lld %s %s in %s %s(%d,%d,%d) old value=%.17g new value=%.17g\n",
+          (long long)iteration,(tag & FLAG_INSIDE) != 0 ? "INSIDE" : "BEFORE",
+          rname.c_str(),bins[bin].c_str(),w.name.c_str(),w.x,w.y,w.z,old_value,new_value);
+        break;
+      }
+      default:
+        ok = false;
+      }
+      if(!ok) {
+        std::cerr << file << ": corrupt record at offset " << (p - data.data()) << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main(int argc,char **argv) {
+  filter_t filter;
+  int n = 1;
+  for(;n+1 < argc && argv[n][0] == '-';n+=2) {
+    const std::string opt = argv[n], arg = argv[n+1];
+    if(opt == "-v") {
+      filter.var = arg;
+    } else if(opt == "-r") {
+      filter.routine = arg;
+    } else if(opt == "-p") {
+      filter.point = sscanf(arg.c_str(),"%d,%d,%d",&filter.x,&filter.y,&filter.z) == 3;
+      if(!filter.point) {
+        std::cerr << "bad point: " << arg << std::endl;
+        return 1;
+      }
+    } else if(opt == "-i") {
+      const size_t colon = arg.find(':');
+      if(colon == std::string::npos) {
+        filter.from = filter.to = atol(arg.c_str());
+      } else {
+        if(colon > 0)
+          filter.from = atol(arg.substr(0,colon).c_str());
+        if(colon+1 < arg.size())
+          filter.to = atol(arg.substr(colon+1).c_str());
+      }
+    } else {
+      std::cerr << "unknown option " << opt << std::endl;
+      return 1;
+    }
+  }
+  if(n >= argc) {
+    std::cerr << "usage: " << argv[0] << " [-v var] [-r routine] [-p x,y,z] [-i from:to] file.bin ..." << std::endl;
+    return 1;
+  }
+  bool ok = true;
+  for(;n < argc;n++)
+    ok &= dump(argv[n],filter);
+  return ok ? 0 : 1;
+}